@@ -0,0 +1,458 @@
+/**
+ * @file perf_suite.cpp
+ * @brief bh_collision_perf: end-to-end cost of canonical runs against a
+ *        stored baseline.
+ *
+ * Usage:
+ *   bh_collision_perf [--only <name>] [--reps <n>] [--report <file>]
+ *                     [--baseline <file>] [--write-baseline]
+ *                     [--time-tol <f>] [--count-tol <f>] [--memory-tol <f>]
+ *
+ * Each scenario goes through the same pipeline as the CLI: run_simulation()
+ * into memory and, through the background writer, into a .bhrun file. It
+ * runs in a child process of its own (bh_collision_perf --scenario <name>),
+ * so its peak RSS is not that of the scenarios before it. Per scenario the
+ * report has
+ *
+ *   wall_ms                  run and export, fastest of --reps runs
+ *   steps                    accepted integrator steps (SimulationStats)
+ *   derivative_evaluations   PN equation-of-motion evaluations
+ *   frames                   frames recorded
+ *   peak_rss_kb              peak resident set size during the run
+ *   bytes_exported           size of the .bhrun file
+ *
+ * and is written as CSV. The comparison flags a metric that grew by more
+ * than its tolerance (a fraction of the baseline value) and exits with 1.
+ * Counts are deterministic, so their tolerance is tight; wall time and
+ * memory depend on the machine, and the checked-in baseline
+ * (bench/perf_baseline.csv) is only a reference for the machine that wrote
+ * it. Regenerate it with --write-baseline after an intended change, or on
+ * the machine that runs the comparison; with --only, the other scenarios
+ * keep their rows. A negative tolerance skips a metric.
+ */
+
+#include "bh_collision/simulation.h"
+#include "bh_collision/frame_sink.h"
+#include "bh_collision/run_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif !defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#ifndef BH_PERF_BASELINE
+#define BH_PERF_BASELINE "bench/perf_baseline.csv"
+#endif
+
+namespace {
+
+// ============================================================================
+// Scenarios
+// ============================================================================
+
+struct Scenario {
+    const char* name;
+    bh::SimulationConfig config;
+};
+
+/// The CLI's production settings: DP54 on the relative orbit
+bh::SimulationConfig production_config()
+{
+    bh::SimulationConfig config;
+    config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    config.integrator.abs_tol = 1e-10;
+    config.integrator.rel_tol = 1e-10;
+    config.integrator.relative_coordinates = true;
+    config.integrator.dt_min = 1e-10;
+    config.integrator.dt_max = 10.0;
+    return config;
+}
+
+std::vector<Scenario> make_scenarios()
+{
+    std::vector<Scenario> scenarios;
+
+    bh::SimulationConfig equal = production_config();
+    equal.binary.initial_separation = 20.0;
+    scenarios.push_back({ "equal_mass_20M", equal });
+
+    bh::SimulationConfig q4 = production_config();
+    q4.binary.m1 = 0.8;
+    q4.binary.m2 = 0.2;
+    q4.binary.initial_separation = 30.0;
+    scenarios.push_back({ "q4_30M", q4 });
+
+    // Spin enters only the remnant and kick fits, not the PN equations of
+    // motion, so at equal masses this row would repeat equal_mass_20M step
+    // for step. q = 1.5 gives it a trajectory of its own.
+    bh::SimulationConfig spinning = production_config();
+    spinning.binary.m1 = 0.6;
+    spinning.binary.m2 = 0.4;
+    spinning.binary.chi1 = 0.7;
+    spinning.binary.chi2 = 0.5;
+    spinning.binary.initial_separation = 20.0;
+    scenarios.push_back({ "spinning", spinning });
+
+    bh::SimulationConfig eccentric = production_config();
+    eccentric.binary.eccentricity = 0.3;
+    eccentric.binary.initial_separation = 20.0;
+    scenarios.push_back({ "eccentric", eccentric });
+
+    // The viewer's fixed-step RK4 run (viewer.cpp)
+    bh::SimulationConfig viewer;
+    viewer.record_interval = 1.0;
+    viewer.binary.initial_separation = 16.0;
+    viewer.integrator.safety_factor = 2.5e-7;
+    viewer.integrator.dt_min = 1e-10;
+    viewer.integrator.dt_max = 0.1;
+    viewer.integrator.relative_coordinates = true;
+    viewer.ringdown_duration = 1400.0;
+    viewer.ringdown_samples = 1500;
+    scenarios.push_back({ "viewer_fidelity", viewer });
+
+    return scenarios;
+}
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+struct Measurement {
+    std::string name;
+    double wall_ms = 0;
+    long long steps = 0;
+    long long derivative_evaluations = 0;
+    long long frames = 0;
+    long long peak_rss_kb = 0;
+    long long bytes_exported = 0;
+};
+
+/// Peak resident set size of this process
+long long peak_rss_kb()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long long)(counters.PeakWorkingSetSize / 1024);
+#elif defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return atoll(line.c_str() + 6);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (long long)usage.ru_maxrss / 1024;   // Bytes on macOS
+#endif
+}
+
+/// One run through the CLI pipeline
+bool measure(const Scenario& scenario, const std::string& path, Measurement& m)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    bh::VectorFrameSink memory_sink;
+    bh::RunFileSink file_sink(path);
+    if (!file_sink.is_open()) return false;
+    bh::SimulationResult result;
+    {
+        bh::AsyncFrameSink writer(file_sink);
+        bh::TeeFrameSink tee(memory_sink, writer);
+        result = bh::run_simulation(scenario.config, tee);
+    }
+    result.frames = std::move(memory_sink.frames);
+    if (!file_sink.complete()) return false;
+
+    auto end = std::chrono::steady_clock::now();
+
+    m.name = scenario.name;
+    m.wall_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    m.steps = result.stats.integrator_steps + result.stats.secular_steps;
+    m.derivative_evaluations = result.stats.derivative_evaluations;
+    m.frames = (long long)result.frames.size();
+    m.peak_rss_kb = peak_rss_kb();
+
+    std::error_code ec;
+    m.bytes_exported = (long long)std::filesystem::file_size(path, ec);
+    return !ec;
+}
+
+/// Fastest of reps runs, in this process
+bool measure_best(const Scenario& scenario, int reps, Measurement& best)
+{
+    std::string path = (std::filesystem::temp_directory_path() /
+                        (std::string("bh_collision_perf_") + scenario.name + ".bhrun")).string();
+    bool ok = true;
+    for (int r = 0; ok && r < reps; r++) {
+        Measurement m;
+        ok = measure(scenario, path, m);
+        if (ok && (r == 0 || m.wall_ms < best.wall_ms)) best = m;
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return ok;
+}
+
+// ============================================================================
+// Report and baseline
+// ============================================================================
+
+const char* CSV_HEADER =
+    "scenario,wall_ms,steps,derivative_evaluations,frames,peak_rss_kb,bytes_exported";
+
+bool write_report(const std::string& filename, const std::vector<Measurement>& measurements)
+{
+    std::ofstream out(filename);
+    if (!out.is_open()) return false;
+    out << CSV_HEADER << "\n";
+    char line[256];
+    for (const Measurement& m : measurements) {
+        snprintf(line, sizeof(line), "%s,%.1f,%lld,%lld,%lld,%lld,%lld\n", m.name.c_str(),
+                 m.wall_ms, m.steps, m.derivative_evaluations, m.frames, m.peak_rss_kb,
+                 m.bytes_exported);
+        out << line;
+    }
+    return out.good();
+}
+
+bool read_report(const std::string& filename, std::vector<Measurement>& measurements)
+{
+    std::ifstream in(filename);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    std::getline(in, line);   // Header
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        Measurement m;
+        if (fields >> m.name >> m.wall_ms >> m.steps >> m.derivative_evaluations >> m.frames
+                   >> m.peak_rss_kb >> m.bytes_exported) {
+            measurements.push_back(m);
+        }
+    }
+    return true;
+}
+
+/// Run one scenario in a child process and read back its report
+bool measure_isolated(const std::string& self, const Scenario& scenario, int reps,
+                      Measurement& m)
+{
+    std::string report = (std::filesystem::temp_directory_path() /
+                          (std::string("bh_collision_perf_") + scenario.name + ".csv")).string();
+    std::string command = "\"" + self + "\" --scenario " + scenario.name +
+                          " --reps " + std::to_string(reps) + " --report \"" + report + "\"";
+#ifdef _WIN32
+    command = "\"" + command + "\"";   // cmd.exe strips the outer quotes
+#endif
+    std::vector<Measurement> rows;
+    bool ok = std::system(command.c_str()) == 0 && read_report(report, rows) && rows.size() == 1;
+    if (ok) m = rows[0];
+
+    std::error_code ec;
+    std::filesystem::remove(report, ec);
+    return ok;
+}
+
+struct Tolerances {
+    double time = 0.25;     // Wall time
+    double count = 0.01;    // Steps, evaluations, frames, bytes
+    double memory = 0.25;   // Peak RSS
+};
+
+/// Print one metric against its baseline; false if it regressed
+bool compare_metric(const char* metric, double value, double baseline, double tolerance)
+{
+    if (tolerance < 0 || baseline <= 0) return true;
+
+    double change = value / baseline - 1.0;
+    const char* verdict = "ok";
+    if (change > tolerance) verdict = "REGRESSION";
+    else if (change < -tolerance) verdict = "improved";
+    printf("    %-24s %14.1f %14.1f %+8.1f%%  %s\n", metric, value, baseline,
+           change * 100.0, verdict);
+    return change <= tolerance;
+}
+
+/// Compare every measured scenario with its baseline row; false on a regression
+bool compare(const std::vector<Measurement>& measurements,
+             const std::vector<Measurement>& baseline, const Tolerances& tol)
+{
+    bool ok = true;
+    printf("\n  %-28s %14s %14s %9s\n", "metric", "measured", "baseline", "change");
+    for (const Measurement& m : measurements) {
+        const Measurement* base = nullptr;
+        for (const Measurement& b : baseline) {
+            if (b.name == m.name) base = &b;
+        }
+        printf("  %s\n", m.name.c_str());
+        if (!base) {
+            printf("    (not in the baseline)\n");
+            continue;
+        }
+        ok &= compare_metric("wall_ms", m.wall_ms, base->wall_ms, tol.time);
+        ok &= compare_metric("steps", (double)m.steps, (double)base->steps, tol.count);
+        ok &= compare_metric("derivative_evaluations", (double)m.derivative_evaluations,
+                             (double)base->derivative_evaluations, tol.count);
+        ok &= compare_metric("frames", (double)m.frames, (double)base->frames, tol.count);
+        ok &= compare_metric("peak_rss_kb", (double)m.peak_rss_kb,
+                             (double)base->peak_rss_kb, tol.memory);
+        ok &= compare_metric("bytes_exported", (double)m.bytes_exported,
+                             (double)base->bytes_exported, tol.count);
+    }
+    return ok;
+}
+
+void print_help()
+{
+    printf(
+        "Usage: bh_collision_perf [options]\n\n"
+        "Options:\n"
+        "  --only <name>       Run only the scenarios whose name contains name\n"
+        "  --reps <n>          Runs per scenario; wall time is the fastest (default 3)\n"
+        "  --report <file>     Write the measurements as CSV\n"
+        "  --baseline <file>   Baseline to compare with (default bench/perf_baseline.csv)\n"
+        "  --write-baseline    Write the measurements to the baseline instead\n"
+        "  --scenario <name>   Measure one scenario in this process and only write\n"
+        "                      the report (what each child process runs)\n"
+        "  --time-tol <f>      Allowed wall time growth, fraction (default 0.25)\n"
+        "  --count-tol <f>     Allowed growth of steps, evaluations, frames and\n"
+        "                      bytes (default 0.01)\n"
+        "  --memory-tol <f>    Allowed peak RSS growth (default 0.25)\n"
+        "                      A negative tolerance skips the metric\n"
+        "  --help              Show this help\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string only, scenario_name, report_file;
+    std::string baseline_file = BH_PERF_BASELINE;
+    bool write_baseline = false;
+    int reps = 3;
+    Tolerances tol;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_help();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        }
+        else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenario_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            report_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--write-baseline") == 0) {
+            write_baseline = true;
+        }
+        else if (strcmp(argv[i], "--time-tol") == 0 && i + 1 < argc) {
+            tol.time = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--count-tol") == 0 && i + 1 < argc) {
+            tol.count = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--memory-tol") == 0 && i + 1 < argc) {
+            tol.memory = atof(argv[++i]);
+        }
+        else {
+            printf("Unknown option: %s\n", argv[i]);
+            print_help();
+            return 1;
+        }
+    }
+
+    std::vector<Scenario> scenarios = make_scenarios();
+
+    // Child process: measure one scenario into the report
+    if (!scenario_name.empty()) {
+        for (const Scenario& scenario : scenarios) {
+            Measurement m;
+            if (scenario_name == scenario.name) {
+                return measure_best(scenario, reps, m) && write_report(report_file, { m }) ? 0 : 1;
+            }
+        }
+        printf("Unknown scenario: %s\n", scenario_name.c_str());
+        return 1;
+    }
+
+    std::vector<Measurement> measurements;
+    printf("  %-20s %10s %10s %12s %10s %10s %12s\n", "scenario", "wall ms", "steps",
+           "evaluations", "frames", "peak KB", "bytes");
+    for (const Scenario& scenario : scenarios) {
+        if (!only.empty() && std::string(scenario.name).find(only) == std::string::npos) continue;
+
+        Measurement m;
+        if (!measure_isolated(argv[0], scenario, reps, m)) {
+            printf("  ERROR: %s failed\n", scenario.name);
+            return 1;
+        }
+        printf("  %-20s %10.1f %10lld %12lld %10lld %10lld %12lld\n", m.name.c_str(),
+               m.wall_ms, m.steps, m.derivative_evaluations, m.frames, m.peak_rss_kb,
+               m.bytes_exported);
+        fflush(stdout);
+        measurements.push_back(m);
+    }
+
+    if (!report_file.empty() && !write_report(report_file, measurements)) {
+        printf("  ERROR: Failed to write %s\n", report_file.c_str());
+        return 1;
+    }
+
+    if (write_baseline) {
+        // Scenarios left out with --only keep their old rows
+        std::vector<Measurement> rows;
+        read_report(baseline_file, rows);
+        for (const Measurement& m : measurements) {
+            auto it = std::find_if(rows.begin(), rows.end(),
+                                   [&](const Measurement& b) { return b.name == m.name; });
+            if (it != rows.end()) *it = m;
+            else rows.push_back(m);
+        }
+        if (!write_report(baseline_file, rows)) {
+            printf("  ERROR: Failed to write %s\n", baseline_file.c_str());
+            return 1;
+        }
+        printf("\n  Baseline written to: %s\n", baseline_file.c_str());
+        return 0;
+    }
+
+    std::vector<Measurement> baseline;
+    if (!read_report(baseline_file, baseline)) {
+        printf("\n  ERROR: No baseline at %s (write one with --write-baseline)\n",
+               baseline_file.c_str());
+        return 1;
+    }
+    bool ok = compare(measurements, baseline, tol);
+    printf("\n  %s\n", ok ? "No regressions." : "Performance regressions found.");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file work_precision.cpp
+ * @brief bh_collision_precision: cost against accuracy of the integrators.
+ *
+ * Usage:
+ *   bh_collision_precision [--m1 <m>] [--m2 <m>] [--sep <a>]
+ *                          [--rk4 <f,f,...>] [--dp54 <tol,tol,...>]
+ *                          [--ref-tol <tol>] [--csv <file>]
+ *                          [--max-time-error <M>] [--max-phase-error <rad>]
+ *                          [--max-cycle-error <n>]
+ *
+ * Runs one binary under a set of integrator settings and compares each run
+ * with a reference run (Dormand-Prince at a tight tolerance and small
+ * dt_max) in
+ *
+ *   merger time              as run_simulation() reports it: the end of the
+ *                            first step that meets the merger condition, so
+ *                            it is resolved to about one step
+ *   phase at merger          orbital phase accumulated from t = 0 to the
+ *                            merger frame
+ *   total_gw_cycles          as run_simulation() reports it
+ *
+ * Cost is the number of derivative evaluations (machine independent) and
+ * the wall time. RK4 runs with the CLI's --integrator rk4 settings apart
+ * from the safety factor (step = factor x orbital period, dt_max 0.1);
+ * DP54 with the CLI's default settings apart from the tolerance.
+ *
+ * The table (or --csv file) is a work-precision diagram; the last line
+ * names the cheapest setting meeting every error budget.
+ */
+
+#include "bh_collision/simulation.h"
+#include "bh_collision/frame_sink.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// ============================================================================
+// Configurations
+// ============================================================================
+
+struct Setting {
+    std::string label;          // e.g. "rk4 safety=1e-04"
+    const char* method;         // "rk4" or "dp54"
+    double parameter;           // Safety factor or tolerance
+    bh::IntegratorConfig integrator;
+};
+
+/// main.cpp's --integrator rk4 settings with the given safety factor
+Setting rk4_setting(double safety_factor)
+{
+    Setting s;
+    char label[64];
+    snprintf(label, sizeof(label), "rk4 safety=%.0e", safety_factor);
+    s.label = label;
+    s.method = "rk4";
+    s.parameter = safety_factor;
+    s.integrator.method = bh::IntegratorMethod::RK4;
+    s.integrator.safety_factor = safety_factor;
+    s.integrator.dt_min = 1e-10;
+    s.integrator.dt_max = 0.1;
+    s.integrator.relative_coordinates = true;
+    return s;
+}
+
+/// main.cpp's default DP54 settings with the given tolerance
+Setting dp54_setting(double tolerance, double dt_max = 10.0)
+{
+    Setting s;
+    char label[64];
+    snprintf(label, sizeof(label), "dp54 tol=%.0e", tolerance);
+    s.label = label;
+    s.method = "dp54";
+    s.parameter = tolerance;
+    s.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    s.integrator.abs_tol = tolerance;
+    s.integrator.rel_tol = tolerance;
+    s.integrator.dt_min = 1e-10;
+    s.integrator.dt_max = dt_max;
+    s.integrator.relative_coordinates = true;
+    return s;
+}
+
+std::vector<double> parse_list(const char* text)
+{
+    std::vector<double> values;
+    for (const char* p = text; *p; ) {
+        char* end;
+        double v = strtod(p, &end);
+        if (end == p) break;
+        values.push_back(v);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+// ============================================================================
+// Runs
+// ============================================================================
+
+/// Accumulates the orbital phase over the inspiral frames and the merger
+/// frame, unwrapping atan2's jumps (frames are far less than half an orbit
+/// apart)
+class PhaseSink : public bh::FrameSink {
+public:
+    void push(const bh::SimulationFrame& frame) override
+    {
+        if (frame.phase > 1) return;
+        double phase = frame.orbital.orbital_phase;
+        if (started_) {
+            double d = phase - last_;
+            d -= 2.0 * M_PI * std::round(d / (2.0 * M_PI));
+            total_ += d;
+        }
+        started_ = true;
+        last_ = phase;
+    }
+
+    double total() const { return total_; }
+
+private:
+    bool started_ = false;
+    double last_ = 0;
+    double total_ = 0;
+};
+
+struct Run {
+    long long steps = 0;
+    long long evaluations = 0;
+    double wall_ms = 0;
+    bool merged = false;
+    double merger_time = 0;
+    double merger_phase = 0;
+    double gw_cycles = 0;
+};
+
+Run run(const bh::SimulationConfig& base, const bh::IntegratorConfig& integrator)
+{
+    bh::SimulationConfig config = base;
+    config.integrator = integrator;
+
+    PhaseSink phase;
+    auto start = std::chrono::steady_clock::now();
+    bh::SimulationResult result = bh::run_simulation(config, phase);
+    auto end = std::chrono::steady_clock::now();
+
+    Run r;
+    r.steps = result.stats.integrator_steps;
+    r.evaluations = result.stats.derivative_evaluations;
+    r.wall_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    r.merged = result.merger_occurred;
+    r.merger_time = result.merger_time;
+    r.merger_phase = std::abs(phase.total());
+    r.gw_cycles = result.total_gw_cycles;
+    return r;
+}
+
+void print_help()
+{
+    printf(
+        "Usage: bh_collision_precision [options]\n\n"
+        "Options:\n"
+        "  --m1 <mass>              Mass of BH1 (fraction of M, default 0.5)\n"
+        "  --m2 <mass>              Mass of BH2 (fraction of M, default 0.5)\n"
+        "  --sep <separation>       Initial separation in M (default 12)\n"
+        "  --rk4 <f,f,...>          RK4 safety factors (default 1e-2,...,1e-6)\n"
+        "  --dp54 <tol,tol,...>     DP54 tolerances (default 1e-6,...,1e-12)\n"
+        "  --ref-tol <tol>          Reference DP54 tolerance (default 1e-13)\n"
+        "  --csv <file>             Also write the results as CSV\n"
+        "  --max-time-error <M>     Merger time budget (default 0.5)\n"
+        "  --max-phase-error <rad>  Phase-at-merger budget (default 0.1)\n"
+        "  --max-cycle-error <n>    GW cycle count budget (default 0.05)\n"
+        "  --help                   Show this help\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bh::SimulationConfig config;
+    config.binary.initial_separation = 12.0;
+    config.ringdown_samples = 1;
+    // 256 frames per orbit: the phase is unwrapped frame to frame
+    config.recording = std::make_shared<bh::PerCycleRecording>(256);
+
+    std::vector<double> safety_factors = { 1e-2, 1e-3, 1e-4, 1e-5, 1e-6 };
+    std::vector<double> tolerances = { 1e-6, 1e-7, 1e-8, 1e-9, 1e-10, 1e-11, 1e-12 };
+    double reference_tol = 1e-13;
+    std::string csv_file;
+    double max_time_error = 0.5, max_phase_error = 0.1, max_cycle_error = 0.05;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_help();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--m1") == 0 && i + 1 < argc) {
+            config.binary.m1 = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--m2") == 0 && i + 1 < argc) {
+            config.binary.m2 = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--sep") == 0 && i + 1 < argc) {
+            config.binary.initial_separation = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--rk4") == 0 && i + 1 < argc) {
+            safety_factors = parse_list(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--dp54") == 0 && i + 1 < argc) {
+            tolerances = parse_list(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--ref-tol") == 0 && i + 1 < argc) {
+            reference_tol = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--max-time-error") == 0 && i + 1 < argc) {
+            max_time_error = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-phase-error") == 0 && i + 1 < argc) {
+            max_phase_error = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-cycle-error") == 0 && i + 1 < argc) {
+            max_cycle_error = atof(argv[++i]);
+        }
+        else {
+            printf("Unknown option: %s\n", argv[i]);
+            print_help();
+            return 1;
+        }
+    }
+
+    double M_total = config.binary.m1 + config.binary.m2;
+    config.binary.m1 /= M_total;
+    config.binary.m2 /= M_total;
+
+    std::vector<Setting> settings;
+    for (double f : safety_factors) settings.push_back(rk4_setting(f));
+    for (double tol : tolerances) settings.push_back(dp54_setting(tol));
+
+    // Small dt_max: the reference merger time is resolved to 0.001 M
+    Run reference = run(config, dp54_setting(reference_tol, 1e-3).integrator);
+    if (!reference.merged) {
+        printf("  ERROR: The reference run did not merge\n");
+        return 1;
+    }
+    printf("  Reference (dp54 tol=%.0e): merger at %.6f M, phase %.6f rad, %.4f GW cycles\n\n",
+           reference_tol, reference.merger_time, reference.merger_phase, reference.gw_cycles);
+
+    FILE* csv = nullptr;
+    if (!csv_file.empty()) {
+        csv = fopen(csv_file.c_str(), "w");
+        if (!csv) {
+            printf("  ERROR: Failed to open %s\n", csv_file.c_str());
+            return 1;
+        }
+        fprintf(csv, "method,parameter,steps,derivative_evaluations,wall_ms,"
+                     "merger_time_error,phase_error,gw_cycles_error\n");
+    }
+
+    printf("  %-20s %12s %14s %10s %12s %12s %12s\n", "setting", "steps", "evaluations",
+           "wall ms", "dt_merger", "d_phase", "d_cycles");
+
+    const Setting* cheapest = nullptr;
+    long long cheapest_cost = 0;
+    for (const Setting& s : settings) {
+        Run r = run(config, s.integrator);
+        double dt = r.merged ? std::abs(r.merger_time - reference.merger_time) : INFINITY;
+        double dphase = r.merged ? std::abs(r.merger_phase - reference.merger_phase) : INFINITY;
+        double dcycles = r.merged ? std::abs(r.gw_cycles - reference.gw_cycles) : INFINITY;
+
+        printf("  %-20s %12lld %14lld %10.1f %12.3e %12.3e %12.3e\n", s.label.c_str(), r.steps,
+               r.evaluations, r.wall_ms, dt, dphase, dcycles);
+        fflush(stdout);
+        if (csv) {
+            fprintf(csv, "%s,%.3e,%lld,%lld,%.1f,%.6e,%.6e,%.6e\n", s.method, s.parameter,
+                    r.steps, r.evaluations, r.wall_ms, dt, dphase, dcycles);
+        }
+
+        bool within = dt <= max_time_error && dphase <= max_phase_error &&
+                      dcycles <= max_cycle_error;
+        if (within && (!cheapest || r.evaluations < cheapest_cost)) {
+            cheapest = &s;
+            cheapest_cost = r.evaluations;
+        }
+    }
+    if (csv) fclose(csv);
+
+    printf("\n  Budget: merger time %.3g M, phase %.3g rad, %.3g GW cycles\n",
+           max_time_error, max_phase_error, max_cycle_error);
+    if (cheapest) {
+        printf("  Cheapest within budget: %s (%lld derivative evaluations)\n",
+               cheapest->label.c_str(), cheapest_cost);
+    } else {
+        printf("  No setting is within budget\n");
+    }
+    if (!csv_file.empty()) {
+        printf("  Results written to: %s\n", csv_file.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file mapped_run.h
+ * @brief Memory-mapped .bhrun files and a render timeline over them.
+ *
+ * load_run() maps a .bhrun file read-only and wraps it in a
+ * CollisionTimelineView, which answers the same queries as CollisionTimeline
+ * but converts frames on demand straight from the mapped columns. Nothing is
+ * copied up front, so opening a run costs a header parse and a binary search
+ * for the merger frame; pages are faulted in as playback reaches them.
+ */
+
+#ifndef BH_COLLISION_MAPPED_RUN_H
+#define BH_COLLISION_MAPPED_RUN_H
+
+#include "run_file.h"
+#include "integration_api.h"
+#include <string>
+#include <vector>
+
+namespace bh {
+
+/// A .bhrun file mapped read-only into memory. Move-only.
+class MappedRun {
+public:
+    MappedRun() = default;
+    ~MappedRun();
+
+    MappedRun(MappedRun&& other) noexcept;
+    MappedRun& operator=(MappedRun&& other) noexcept;
+    MappedRun(const MappedRun&) = delete;
+    MappedRun& operator=(const MappedRun&) = delete;
+
+    /// Map the file and check its header and chunk index. On failure
+    /// error() says why.
+    bool open(const std::string& filename);
+
+    const std::string& error() const { return error_; }
+    const RunFileLayout& layout() const { return layout_; }
+
+    /// Run summary from the header; its frames are empty
+    const ColumnarResult& summary() const { return summary_; }
+
+    size_t size() const { return (size_t)layout_.num_frames; }
+
+    /// Column c of chunk i: layout().chunks[i].num_frames doubles
+    const double* column(size_t chunk, RunColumn c) const;
+
+    /// Value of column c for frame i
+    double value(size_t i, RunColumn c) const
+    {
+        size_t chunk = i / (size_t)layout_.chunk_frames;
+        return column(chunk, c)[i - chunk * (size_t)layout_.chunk_frames];
+    }
+
+    /// Reassemble frame i. A damaged phase value is clamped to 0-3.
+    SimulationFrame frame(size_t i) const;
+
+private:
+    void close();
+
+    const unsigned char* data_ = nullptr;
+    size_t bytes_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;      // HANDLE
+    void* mapping_ = nullptr;   // HANDLE
+#endif
+    std::string error_;
+    RunFileLayout layout_ = {};
+    ColumnarResult summary_ = {};
+};
+
+/// CollisionTimeline over a mapped run. Frames are converted when they are
+/// asked for; interpolate() gives the same result as CollisionTimeline built
+/// from the same frames.
+class CollisionTimelineView {
+public:
+    float total_duration = 0;
+    float merger_time = 0;
+    int merger_frame_index = -1;
+
+    const MappedRun& run() const { return run_; }
+    size_t size() const { return run_.size(); }
+
+    /// Render data of frame i
+    CollisionRenderData frame(size_t i) const;
+
+    /// Get interpolated render data at arbitrary time t
+    CollisionRenderData interpolate(float t) const;
+
+    // The lookup steps of interpolate(), as in CollisionTimeline (for
+    // TimelineCursor)
+    float frame_time(size_t i) const { return (float)run_.value(i, RunColumn::time); }
+    size_t find_frame(float t) const;
+    CollisionRenderData interpolate_from(size_t lo, float t) const;
+
+private:
+    friend bool load_run(const std::string&, CollisionTimelineView&, std::string*);
+
+    MappedRun run_;
+};
+
+/// Map a .bhrun file and build a timeline view over it. On failure returns
+/// false and, if error is not null, sets it to the reason.
+bool load_run(const std::string& filename, CollisionTimelineView& view, std::string* error = nullptr);
+
+} // namespace bh
+
+#endif // BH_COLLISION_MAPPED_RUN_H
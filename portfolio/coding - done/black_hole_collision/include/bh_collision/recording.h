@@ -0,0 +1,119 @@
+/**
+ * @file recording.h
+ * @brief When run_simulation() records inspiral frames.
+ *
+ * The first frame is recorded at t = 0. After each inspiral frame,
+ * run_simulation() asks the policy in SimulationConfig::recording for the
+ * time of the next one and evaluates it from the integrator's dense output,
+ * so the cadence never constrains the step size. The merger frame and the
+ * ringdown samples are recorded regardless of the policy.
+ *
+ * Without a policy the run keeps its classic cadence, PlungeRefinedRecording
+ * with SimulationConfig::record_interval: one frame per interval, and 4000
+ * times as many once the separation drops below 10 M. That plunge sampling
+ * is most of the frames of a run; a consumer that only needs the orbit's
+ * shape does far better with a fixed number of frames per orbit:
+ *
+ *   config.recording = std::make_shared<bh::PerCycleRecording>(64);
+ *
+ * Policies are shared between copies of the config (and between the runs
+ * of a sweep), so next_time() must not change the policy.
+ */
+
+#ifndef BH_COLLISION_RECORDING_H
+#define BH_COLLISION_RECORDING_H
+
+#include <functional>
+#include <utility>
+
+namespace bh {
+
+struct SimulationFrame;   // simulation.h
+
+/// Chooses the inspiral frame times
+class RecordingPolicy {
+public:
+    virtual ~RecordingPolicy() = default;
+
+    /// Time of the frame after the one just recorded. A time not after
+    /// frame.time records the next frame at the end of the current
+    /// integrator step.
+    virtual double next_time(const SimulationFrame& frame) const = 0;
+};
+
+/// One frame every interval M
+class UniformTimeRecording : public RecordingPolicy {
+public:
+    explicit UniformTimeRecording(double interval) : interval_(interval) {}
+
+    double next_time(const SimulationFrame& frame) const override;
+
+private:
+    double interval_;
+};
+
+/// One frame every interval M, and one every interval / refine_factor
+/// while the separation is below refine_separation (in units of the total
+/// mass). The default policy, with run_simulation's classic 4000x below
+/// 10 M.
+class PlungeRefinedRecording : public RecordingPolicy {
+public:
+    explicit PlungeRefinedRecording(double interval, double refine_factor = 4000.0,
+                                    double refine_separation = 10.0)
+        : interval_(interval), refine_factor_(refine_factor), refine_separation_(refine_separation) {}
+
+    double next_time(const SimulationFrame& frame) const override;
+
+private:
+    double interval_;
+    double refine_factor_;
+    double refine_separation_;
+};
+
+/// samples frames per orbit at the current orbital frequency, but at least
+/// one every max_interval M
+class PerCycleRecording : public RecordingPolicy {
+public:
+    explicit PerCycleRecording(int samples, double max_interval = 100.0)
+        : samples_(samples < 1 ? 1 : samples), max_interval_(max_interval) {}
+
+    double next_time(const SimulationFrame& frame) const override;
+
+private:
+    int samples_;
+    double max_interval_;
+};
+
+/// A frame each time the GW frequency has risen by about delta_f (in 1/M),
+/// from the leading-order chirp rate
+///   df/dt = (96/5) π^(8/3) M_c^(5/3) f^(11/3),
+/// but at least one every max_interval M. Spends frames where the signal
+/// changes, which suits spectral and matched-filter work.
+class GWFrequencyRecording : public RecordingPolicy {
+public:
+    explicit GWFrequencyRecording(double delta_f, double max_interval = 100.0)
+        : delta_f_(delta_f), max_interval_(max_interval) {}
+
+    double next_time(const SimulationFrame& frame) const override;
+
+private:
+    double delta_f_;
+    double max_interval_;
+};
+
+/// Calls a caller-supplied function for the next time
+class CallbackRecording : public RecordingPolicy {
+public:
+    using Callback = std::function<double(const SimulationFrame&)>;
+
+    explicit CallbackRecording(Callback callback) : callback_(std::move(callback)) {}
+
+    double next_time(const SimulationFrame& frame) const override { return callback_(frame); }
+
+private:
+    Callback callback_;
+};
+
+} // namespace bh
+
+#endif // BH_COLLISION_RECORDING_H
@@ -0,0 +1,161 @@
+/**
+ * @file run_file.h
+ * @brief Versioned binary container for simulation results (.bhrun).
+ *
+ * export_to_json() spends ~600 bytes of formatted text per frame, so a run
+ * with the fine plunge sampling becomes gigabytes that are slow to write and
+ * slower to parse. A .bhrun file stores the same data as raw doubles:
+ *
+ *   header   384 bytes: magic, version, counts, index offset, and the run
+ *            summary (config, merger, remnant, QNM)
+ *   chunks   up to chunk_frames frames each, one contiguous array of
+ *            little-endian doubles per column (RunColumn order), every
+ *            chunk starting on a 64-byte boundary
+ *   index    per chunk: file offset, first frame, frame count
+ *
+ * Column c of a chunk with n frames starts at chunk.offset + c * n * 8.
+ * The writer streams (RunFileSink is a FrameSink) and patches the header
+ * when the run finishes. Files are written and read on little-endian hosts
+ * only; the writer and reader fail on anything else.
+ *
+ * JSON remains available for small runs and for tools that need text.
+ */
+
+#ifndef BH_COLLISION_RUN_FILE_H
+#define BH_COLLISION_RUN_FILE_H
+
+#include "columnar.h"
+#include "frame_sink.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace bh {
+
+constexpr uint32_t RUN_FILE_VERSION = 1;
+constexpr size_t RUN_FILE_HEADER_BYTES = 384;
+constexpr size_t RUN_FILE_DEFAULT_CHUNK_FRAMES = 16384;
+
+/// Columns of a .bhrun chunk, in file order. Every column is stored as
+/// doubles, including phase.
+enum class RunColumn : int {
+    time, phase,
+    bh1_mass, bh1_chi, bh1_x, bh1_y, bh1_z, bh1_vx, bh1_vy, bh1_vz,
+    bh1_spin_x, bh1_spin_y, bh1_spin_z,
+    bh2_mass, bh2_chi, bh2_x, bh2_y, bh2_z, bh2_vx, bh2_vy, bh2_vz,
+    bh2_spin_x, bh2_spin_y, bh2_spin_z,
+    separation, orbital_frequency, orbital_phase, radial_velocity,
+    velocity_param, reduced_mass, total_mass, symmetric_mass_ratio,
+    chirp_mass, energy, angular_momentum,
+    h_plus, h_cross, gw_amplitude, gw_frequency,
+    count
+};
+
+constexpr size_t RUN_FILE_NUM_COLUMNS = (size_t)RunColumn::count;
+
+/// Location of one chunk
+struct RunChunk {
+    uint64_t offset;        // File offset of the chunk's first column
+    uint64_t first_frame;
+    uint64_t num_frames;
+};
+
+/// Everything in a .bhrun file except the frame data
+struct RunFileLayout {
+    uint32_t version;
+    uint64_t num_frames;
+    uint64_t chunk_frames;
+    uint64_t index_offset;
+    std::vector<RunChunk> chunks;
+};
+
+/// Streams frames into a .bhrun file, one chunk at a time. The header is
+/// rewritten with the run summary in finish(), so the file is complete only
+/// after the run has finished.
+class RunFileSink : public FrameSink {
+public:
+    explicit RunFileSink(const std::string& filename,
+                         size_t chunk_frames = RUN_FILE_DEFAULT_CHUNK_FRAMES);
+
+    /// False if the file could not be created or the host is big-endian;
+    /// frames are then dropped
+    bool is_open() const { return out_.is_open(); }
+
+    /// True once finish() has written the index and header without error
+    bool complete() const { return complete_; }
+
+    void push(const SimulationFrame& frame) override;
+    void finish(const SimulationResult& summary) override;
+
+private:
+    void flush_chunk();
+
+    std::ofstream out_;
+    size_t chunk_frames_;
+    FrameColumns pending_;
+    RunFileLayout layout_ = {};
+    bool complete_ = false;
+};
+
+/// Write a whole result to a .bhrun file. With an executor (sweep.h),
+/// chunks are gathered into columns on its threads and written in order;
+/// the file is the same as without.
+bool write_run(const std::string& filename, const SimulationResult& result,
+               size_t chunk_frames = RUN_FILE_DEFAULT_CHUNK_FRAMES,
+               Executor* executor = nullptr);
+bool write_run(const std::string& filename, const ColumnarResult& result,
+               size_t chunk_frames = RUN_FILE_DEFAULT_CHUNK_FRAMES);
+
+/// Reads a .bhrun file chunk by chunk
+class RunFileReader {
+public:
+    /// Read the header and chunk index. On failure error() says why.
+    bool open(const std::string& filename);
+
+    const std::string& error() const { return error_; }
+    const RunFileLayout& layout() const { return layout_; }
+
+    /// Run summary from the header; its frames are empty
+    const ColumnarResult& summary() const { return summary_; }
+
+    /// Append the frames of chunk i to out
+    bool read_chunk(size_t i, FrameColumns& out);
+
+private:
+    std::ifstream in_;
+    std::string error_;
+    RunFileLayout layout_ = {};
+    ColumnarResult summary_ = {};
+    std::vector<double> buffer_;
+};
+
+/// Read a whole .bhrun file. On failure returns false and, if error is not
+/// null, sets it to the reason.
+bool read_run(const std::string& filename, ColumnarResult& result, std::string* error = nullptr);
+bool read_run(const std::string& filename, SimulationResult& result, std::string* error = nullptr);
+
+namespace detail {
+
+/// .bhrun data is read and written without byte swapping
+bool host_is_little_endian();
+
+/// Decode a header (RUN_FILE_HEADER_BYTES bytes) into the layout and the
+/// run summary. layout.chunks is sized but left for parse_run_index(); the
+/// index offset and chunk count are checked against file_size first, so a
+/// corrupt header cannot ask for more chunks than the file holds.
+bool parse_run_header(const unsigned char* data, size_t size, uint64_t file_size,
+                      RunFileLayout& layout, ColumnarResult& summary, std::string& error);
+
+/// Decode the chunk index (24 bytes per chunk) that follows the last chunk
+/// and check it against the frame count. Chunks must lie in file order
+/// between the header and the index, so the frame count is bounded by the
+/// file size.
+bool parse_run_index(const unsigned char* data, size_t size,
+                     RunFileLayout& layout, std::string& error);
+
+} // namespace detail
+
+} // namespace bh
+
+#endif // BH_COLLISION_RUN_FILE_H
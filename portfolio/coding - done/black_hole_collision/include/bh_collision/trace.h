@@ -0,0 +1,100 @@
+/**
+ * @file trace.h
+ * @brief Scoped timing spans, written as Chrome trace-event JSON.
+ *
+ * BH_TRACE_SCOPE("name") records the time from the statement to the end of
+ * the enclosing block as one span on the calling thread, while tracing is
+ * on:
+ *
+ *   bh::trace_start();
+ *   ... run, export, render ...
+ *   bh::trace_stop();
+ *   bh::write_trace("trace.json");
+ *
+ * The file opens in ui.perfetto.dev or chrome://tracing, one track per
+ * thread, so a sweep shows each job on its worker and a .bhrun export shows
+ * the background writer next to the integrator.
+ *
+ * Each thread appends to a buffer of its own without locks; only its first
+ * span takes a mutex, to register the buffer. A span while tracing is off
+ * costs one relaxed atomic load. Span names are not copied: pass string
+ * literals. Build with BH_ENABLE_TRACE=0 to compile the spans out.
+ */
+
+#ifndef BH_COLLISION_TRACE_H
+#define BH_COLLISION_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#ifndef BH_ENABLE_TRACE
+#define BH_ENABLE_TRACE 1
+#endif
+
+namespace bh {
+
+/// Record spans from now on. Spans from before the latest start are left
+/// out of write_trace().
+void trace_start();
+
+/// Stop recording; spans already open still finish
+void trace_stop();
+
+/// Write the spans recorded since trace_start() as trace-event JSON.
+/// Threads may still be tracing; spans they have not finished are left out.
+bool write_trace(const std::string& filename);
+
+namespace detail {
+
+extern std::atomic<bool> trace_on;
+
+inline uint64_t trace_now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Append a finished span to the calling thread's buffer
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+} // namespace detail
+
+inline bool trace_enabled()
+{
+    return detail::trace_on.load(std::memory_order_relaxed);
+}
+
+/// Records its lifetime as a span if tracing was on when it was created
+class TraceScope {
+public:
+    explicit TraceScope(const char* name)
+        : name_(trace_enabled() ? name : nullptr),
+          start_ns_(name_ ? detail::trace_now_ns() : 0) {}
+
+    ~TraceScope()
+    {
+        if (name_) detail::trace_record(name_, start_ns_, detail::trace_now_ns());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_ns_;
+};
+
+} // namespace bh
+
+#define BH_TRACE_CONCAT_(a, b) a##b
+#define BH_TRACE_CONCAT(a, b) BH_TRACE_CONCAT_(a, b)
+
+#if BH_ENABLE_TRACE
+#define BH_TRACE_SCOPE(name) ::bh::TraceScope BH_TRACE_CONCAT(bh_trace_scope_, __LINE__)(name)
+#else
+#define BH_TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif // BH_COLLISION_TRACE_H
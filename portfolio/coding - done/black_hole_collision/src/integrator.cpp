@@ -1,6 +1,7 @@
 /**
  * @file integrator.cpp
- * @brief RK4 integrator implementation with adaptive time stepping.
+ * @brief RK4 and Dormand-Prince 5(4) integrator implementations with
+ *        adaptive time stepping.
  */
 
 #include "bh_collision/integrator.h"
@@ -9,78 +10,100 @@
 
 namespace bh {
 
-// Helper: apply a state derivative scaled by dt
-BinaryState state_add(const BinaryState& s, const BinaryStateDerivative& d, double dt) {
-    BinaryState result;
-    result.pos1 = s.pos1 + d.dpos1 * dt;
-    result.vel1 = s.vel1 + d.dvel1 * dt;
-    result.pos2 = s.pos2 + d.dpos2 * dt;
-    result.vel2 = s.vel2 + d.dvel2 * dt;
-    result.time = s.time + dt;
-    return result;
-}
-
 BinaryState rk4_step(
     const BinaryState& state,
     double dt,
     const DerivativeFunc& deriv)
 {
-    // Classic 4th-order Runge-Kutta
-    BinaryStateDerivative k1 = deriv(state);
-    BinaryStateDerivative k2 = deriv(state_add(state, k1, dt * 0.5));
-    BinaryStateDerivative k3 = deriv(state_add(state, k2, dt * 0.5));
-    BinaryStateDerivative k4 = deriv(state_add(state, k3, dt));
-
-    BinaryState result;
-    result.time = state.time + dt;
-
-    // Weighted sum: y_{n+1} = y_n + (dt/6)(k1 + 2k2 + 2k3 + k4)
-    result.pos1 = state.pos1 + (dt / 6.0) * (k1.dpos1 + 2.0 * k2.dpos1 + 2.0 * k3.dpos1 + k4.dpos1);
-    result.vel1 = state.vel1 + (dt / 6.0) * (k1.dvel1 + 2.0 * k2.dvel1 + 2.0 * k3.dvel1 + k4.dvel1);
-    result.pos2 = state.pos2 + (dt / 6.0) * (k1.dpos2 + 2.0 * k2.dpos2 + 2.0 * k3.dpos2 + k4.dpos2);
-    result.vel2 = state.vel2 + (dt / 6.0) * (k1.dvel2 + 2.0 * k2.dvel2 + 2.0 * k3.dvel2 + k4.dvel2);
-
-    return result;
+    return rk4_step<BinaryState, DerivativeFunc>(state, dt, deriv);
 }
 
-double adaptive_timestep(
+// ============================================================================
+// Dormand-Prince 5(4) embedded pair (stepper is templated in integrator.h)
+// ============================================================================
+
+AdaptiveStepResult dopri5_step(
     const BinaryState& state,
+    const BinaryStateDerivative& k1,
+    double dt,
+    const DerivativeFunc& deriv,
     const IntegratorConfig& config,
-    double total_mass)
+    DenseOutput* dense)
 {
-    if (!config.adaptive) {
-        return config.dt_initial;
-    }
+    return dopri5_step<BinaryState, BinaryStateDerivative, DerivativeFunc>(
+        state, k1, dt, deriv, config, dense);
+}
+
+namespace detail {
 
-    // Compute separation
-    glm::dvec3 r = state.pos1 - state.pos2;
-    double separation = glm::length(r);
+double scaled_error(const BinaryState& y0, const BinaryState& y1,
+                    const BinaryStateDerivative& err,
+                    double atol, double rtol)
+{
+    const glm::dvec3* a[4] = { &y0.pos1, &y0.vel1, &y0.pos2, &y0.vel2 };
+    const glm::dvec3* b[4] = { &y1.pos1, &y1.vel1, &y1.pos2, &y1.vel2 };
+    const glm::dvec3* e[4] = { &err.dpos1, &err.dvel1, &err.dpos2, &err.dvel2 };
+
+    double sum = 0.0;
+    for (int v = 0; v < 4; v++) {
+        for (int c = 0; c < 3; c++) {
+            double scale = atol + rtol * std::max(std::abs((*a[v])[c]), std::abs((*b[v])[c]));
+            double q = (*e[v])[c] / scale;
+            sum += q * q;
+        }
+    }
+    return std::sqrt(sum / 12.0);
+}
 
-    if (separation < 1e-10) {
-        return config.dt_min;
+double scaled_error(const RelativeState& y0, const RelativeState& y1,
+                    const RelativeStateDerivative& err,
+                    double atol, double rtol)
+{
+    const glm::dvec3* a[2] = { &y0.r, &y0.v };
+    const glm::dvec3* b[2] = { &y1.r, &y1.v };
+    const glm::dvec3* e[2] = { &err.dr, &err.dv };
+
+    double sum = 0.0;
+    for (int v = 0; v < 2; v++) {
+        for (int c = 0; c < 3; c++) {
+            double scale = atol + rtol * std::max(std::abs((*a[v])[c]), std::abs((*b[v])[c]));
+            double q = (*e[v])[c] / scale;
+            sum += q * q;
+        }
     }
+    return std::sqrt(sum / 6.0);
+}
+
+} // namespace detail
 
-    // Orbital period estimate: T = 2π / ω = 2π sqrt(r³/M)
-    double orbital_period = 2.0 * M_PI * std::sqrt(
-        separation * separation * separation / total_mass
-    );
-
-    // Time step = safety_factor * orbital_period
-    // This ensures we take enough steps per orbit for accuracy
-    double dt = config.safety_factor * orbital_period;
-
-    // As BHs get very close, use even smaller steps
-    // Scale additionally by (r / r_isco) when close
-    double r_isco = 6.0 * total_mass;  // Schwarzschild ISCO for total mass
-    if (separation < 2.0 * r_isco) {
-        double scale = separation / (2.0 * r_isco);
-        dt *= scale * scale;
+static double adaptive_timestep_for_separation(
+    double separation,
+    const IntegratorConfig& config,
+    double total_mass)
+{
+    if (!config.adaptive) {
+        return config.dt_initial;
     }
 
-    // Clamp to allowed range
-    dt = std::clamp(dt, config.dt_min, config.dt_max);
+    return orbital_timestep(separation, config.safety_factor,
+                            config.dt_min, config.dt_max, total_mass);
+}
 
-    return dt;
+double adaptive_timestep(
+    const BinaryState& state,
+    const IntegratorConfig& config,
+    double total_mass)
+{
+    return adaptive_timestep_for_separation(
+        glm::length(state.pos1 - state.pos2), config, total_mass);
+}
+
+double adaptive_timestep(
+    const RelativeState& state,
+    const IntegratorConfig& config,
+    double total_mass)
+{
+    return adaptive_timestep_for_separation(glm::length(state.r), config, total_mass);
 }
 
 } // namespace bh
@@ -0,0 +1,229 @@
+/**
+ * @file json_writer.cpp
+ * @brief JsonWriter and the JSON layout of frames and run summaries.
+ */
+
+#include "bh_collision/json_writer.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace bh {
+
+// ============================================================================
+// JsonWriter
+// ============================================================================
+
+JsonWriter::JsonWriter(std::ostream& out, bool compact)
+    : out_(&out), compact_(compact)
+{
+    buffer_.reserve(FLUSH_BYTES + 4096);
+}
+
+JsonWriter::JsonWriter(bool compact)
+    : out_(nullptr), compact_(compact)
+{
+}
+
+void JsonWriter::begin_value(const char* key)
+{
+    if (!has_items_.empty()) {
+        if (has_items_.back()) buffer_ += ',';
+        has_items_.back() = true;
+        if (!compact_) {
+            buffer_ += '\n';
+            buffer_.append(2 * has_items_.size(), ' ');
+        }
+    }
+
+    if (key) {
+        buffer_ += '"';
+        buffer_ += key;
+        buffer_ += compact_ ? "\":" : "\": ";
+    }
+}
+
+void JsonWriter::close_container(char bracket)
+{
+    has_items_.pop_back();
+    if (!compact_) {
+        buffer_ += '\n';
+        buffer_.append(2 * has_items_.size(), ' ');
+    }
+    buffer_ += bracket;
+    maybe_flush();
+}
+
+void JsonWriter::begin_object(const char* key)
+{
+    begin_value(key);
+    buffer_ += '{';
+    has_items_.push_back(false);
+}
+
+void JsonWriter::end_object()
+{
+    close_container('}');
+}
+
+void JsonWriter::begin_array(const char* key)
+{
+    begin_value(key);
+    buffer_ += '[';
+    has_items_.push_back(false);
+}
+
+void JsonWriter::end_array()
+{
+    close_container(']');
+}
+
+void JsonWriter::append_number(double value)
+{
+    char text[32];
+    auto res = std::to_chars(text, text + sizeof(text), value);
+    buffer_.append(text, res.ptr);
+}
+
+void JsonWriter::number(const char* key, double value)
+{
+    begin_value(key);
+    append_number(value);
+}
+
+void JsonWriter::number(const char* key, long long value)
+{
+    begin_value(key);
+    char text[24];
+    auto res = std::to_chars(text, text + sizeof(text), value);
+    buffer_.append(text, res.ptr);
+}
+
+void JsonWriter::boolean(const char* key, bool value)
+{
+    begin_value(key);
+    buffer_ += value ? "true" : "false";
+}
+
+void JsonWriter::string(const char* key, const char* value)
+{
+    begin_value(key);
+    buffer_ += '"';
+    buffer_ += value;
+    buffer_ += '"';
+}
+
+void JsonWriter::vec3(const char* key, const glm::dvec3& v)
+{
+    const char* separator = compact_ ? "," : ", ";
+    begin_value(key);
+    buffer_ += '[';
+    append_number(v.x);
+    buffer_ += separator;
+    append_number(v.y);
+    buffer_ += separator;
+    append_number(v.z);
+    buffer_ += ']';
+}
+
+void JsonWriter::raw(const char* text)
+{
+    buffer_ += text;
+}
+
+void JsonWriter::continue_array(size_t depth, bool has_items)
+{
+    has_items_.assign(depth, true);
+    if (depth > 0) has_items_.back() = has_items;
+}
+
+bool JsonWriter::flush()
+{
+    if (!out_) return true;
+
+    if (!buffer_.empty()) {
+        out_->write(buffer_.data(), (std::streamsize)buffer_.size());
+        buffer_.clear();
+    }
+    return out_->good();
+}
+
+// ============================================================================
+// Frame and summary layout
+// ============================================================================
+
+namespace detail {
+
+void write_json_frame(JsonWriter& json, const SimulationFrame& f)
+{
+    json.begin_object();
+    json.number("time", f.time);
+    json.number("phase", (long long)f.phase);
+
+    json.begin_object("bh1");
+    json.number("mass", f.bh1.mass);
+    json.vec3("position", f.bh1.position);
+    json.vec3("velocity", f.bh1.velocity);
+    json.end_object();
+
+    json.begin_object("bh2");
+    json.number("mass", f.bh2.mass);
+    json.vec3("position", f.bh2.position);
+    json.vec3("velocity", f.bh2.velocity);
+    json.end_object();
+
+    json.begin_object("orbital");
+    json.number("separation", f.orbital.separation);
+    json.number("frequency", f.orbital.orbital_frequency);
+    json.number("energy", f.orbital.energy);
+    json.end_object();
+
+    json.begin_object("gw");
+    json.number("h_plus", f.gw.h_plus);
+    json.number("h_cross", f.gw.h_cross);
+    json.number("amplitude", f.gw.amplitude);
+    json.number("frequency", f.gw.frequency);
+    json.end_object();
+
+    json.end_object();
+}
+
+void write_json_summary(JsonWriter& json, const SimulationResult& result, size_t num_frames)
+{
+    json.begin_object("metadata");
+    json.string("units", "geometrized (G=c=1)");
+    json.string("mass_unit", "total_mass_M");
+    json.string("length_unit", "M");
+    json.string("time_unit", "M");
+    json.number("num_frames", (long long)num_frames);
+    json.boolean("merger_occurred", result.merger_occurred);
+    json.number("merger_time", result.merger_time);
+    json.number("total_gw_cycles", result.total_gw_cycles);
+    json.number("energy_radiated_fraction", result.total_energy_radiated);
+    json.end_object();
+
+    json.begin_object("config");
+    json.number("m1", result.config.m1);
+    json.number("m2", result.config.m2);
+    json.number("chi1", result.config.chi1);
+    json.number("chi2", result.config.chi2);
+    json.number("initial_separation", result.config.initial_separation);
+    json.number("eccentricity", result.config.eccentricity);
+    json.end_object();
+
+    if (result.merger_occurred) {
+        json.begin_object("remnant");
+        json.number("mass", result.remnant.mass);
+        json.number("spin", result.remnant.spin);
+        json.number("kick_velocity", result.remnant.kick_velocity);
+        json.number("energy_radiated", result.remnant.energy_radiated);
+        json.vec3("position", result.remnant.position);
+        json.number("qnm_frequency", result.qnm.frequency);
+        json.number("qnm_damping_time", result.qnm.damping_time);
+        json.end_object();
+    }
+}
+
+} // namespace detail
+
+} // namespace bh
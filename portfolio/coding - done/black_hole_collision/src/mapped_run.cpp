@@ -0,0 +1,303 @@
+/**
+ * @file mapped_run.cpp
+ * @brief Memory-mapped .bhrun loader and timeline view.
+ */
+
+#include "bh_collision/mapped_run.h"
+#include "bh_collision/trace.h"
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bh {
+
+// ============================================================================
+// MappedRun
+// ============================================================================
+
+MappedRun::~MappedRun()
+{
+    close();
+}
+
+MappedRun::MappedRun(MappedRun&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedRun& MappedRun::operator=(MappedRun&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        bytes_ = std::exchange(other.bytes_, 0);
+#ifdef _WIN32
+        file_ = std::exchange(other.file_, nullptr);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+        error_ = std::move(other.error_);
+        layout_ = std::move(other.layout_);
+        summary_ = std::move(other.summary_);
+    }
+    return *this;
+}
+
+void MappedRun::close()
+{
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+    file_ = nullptr;
+    mapping_ = nullptr;
+#else
+    if (data_) munmap(const_cast<unsigned char*>(data_), bytes_);
+#endif
+    data_ = nullptr;
+    bytes_ = 0;
+}
+
+bool MappedRun::open(const std::string& filename)
+{
+    close();
+    error_.clear();
+    layout_ = {};
+    summary_ = {};
+
+    if (!detail::host_is_little_endian()) {
+        error_ = ".bhrun files need a little-endian host";
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error_ = "cannot open " + filename;
+        return false;
+    }
+    file_ = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || (uint64_t)file_size.QuadPart < RUN_FILE_HEADER_BYTES) {
+        error_ = "not a .bhrun file";
+        close();
+        return false;
+    }
+    bytes_ = (size_t)file_size.QuadPart;
+
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_) {
+        data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!data_) {
+        error_ = "cannot map " + filename;
+        close();
+        return false;
+    }
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "cannot open " + filename;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < RUN_FILE_HEADER_BYTES) {
+        error_ = "not a .bhrun file";
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file referenced, so the descriptor can go
+    void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error_ = "cannot map " + filename;
+        return false;
+    }
+    data_ = static_cast<const unsigned char*>(mapped);
+    bytes_ = (size_t)st.st_size;
+#endif
+
+    bool ok = detail::parse_run_header(data_, bytes_, bytes_, layout_, summary_, error_);
+    if (ok) {
+        ok = detail::parse_run_index(data_ + layout_.index_offset,
+                                     bytes_ - (size_t)layout_.index_offset, layout_, error_);
+    }
+
+    // column() hands out pointers into the mapping, so check once more here
+    // that every chunk's columns end inside it (without sums that can wrap).
+    // value() finds a frame's chunk by division, so every chunk but the
+    // last must be full. The writers always produce files like that.
+    const uint64_t frame_bytes = RUN_FILE_NUM_COLUMNS * sizeof(double);
+    for (size_t i = 0; ok && i < layout_.chunks.size(); i++) {
+        const RunChunk& chunk = layout_.chunks[i];
+        if (chunk.offset > bytes_ || chunk.num_frames > (bytes_ - chunk.offset) / frame_bytes) {
+            error_ = "corrupt .bhrun chunk index";
+            ok = false;
+            break;
+        }
+
+        uint64_t n = chunk.num_frames;
+        bool last = i + 1 == layout_.chunks.size();
+        if (n > layout_.chunk_frames || (!last && n != layout_.chunk_frames)) {
+            error_ = "irregular .bhrun chunk sizes";
+            ok = false;
+        }
+    }
+
+    if (!ok) close();
+    return ok;
+}
+
+const double* MappedRun::column(size_t chunk, RunColumn c) const
+{
+    const RunChunk& info = layout_.chunks[chunk];
+    return reinterpret_cast<const double*>(data_ + info.offset) + (size_t)c * info.num_frames;
+}
+
+SimulationFrame MappedRun::frame(size_t i) const
+{
+    size_t chunk = i / (size_t)layout_.chunk_frames;
+    size_t k = i - chunk * (size_t)layout_.chunk_frames;
+    auto at = [&](RunColumn c) { return column(chunk, c)[k]; };
+
+    SimulationFrame f;
+    f.time = at(RunColumn::time);
+    // Columns are not checked on open, so clamp a damaged phase (NaN or out
+    // of range) instead of converting it to int
+    double phase = at(RunColumn::phase);
+    f.phase = phase >= 3.0 ? 3 : (phase > 0.0 ? (int)phase : 0);
+
+    f.bh1.mass = at(RunColumn::bh1_mass);
+    f.bh1.chi = at(RunColumn::bh1_chi);
+    f.bh1.position = glm::dvec3(at(RunColumn::bh1_x), at(RunColumn::bh1_y), at(RunColumn::bh1_z));
+    f.bh1.velocity = glm::dvec3(at(RunColumn::bh1_vx), at(RunColumn::bh1_vy), at(RunColumn::bh1_vz));
+    f.bh1.spin_axis = glm::dvec3(at(RunColumn::bh1_spin_x), at(RunColumn::bh1_spin_y),
+                                 at(RunColumn::bh1_spin_z));
+
+    f.bh2.mass = at(RunColumn::bh2_mass);
+    f.bh2.chi = at(RunColumn::bh2_chi);
+    f.bh2.position = glm::dvec3(at(RunColumn::bh2_x), at(RunColumn::bh2_y), at(RunColumn::bh2_z));
+    f.bh2.velocity = glm::dvec3(at(RunColumn::bh2_vx), at(RunColumn::bh2_vy), at(RunColumn::bh2_vz));
+    f.bh2.spin_axis = glm::dvec3(at(RunColumn::bh2_spin_x), at(RunColumn::bh2_spin_y),
+                                 at(RunColumn::bh2_spin_z));
+
+    f.orbital.separation = at(RunColumn::separation);
+    f.orbital.orbital_frequency = at(RunColumn::orbital_frequency);
+    f.orbital.orbital_phase = at(RunColumn::orbital_phase);
+    f.orbital.radial_velocity = at(RunColumn::radial_velocity);
+    f.orbital.velocity_param = at(RunColumn::velocity_param);
+    f.orbital.reduced_mass = at(RunColumn::reduced_mass);
+    f.orbital.total_mass = at(RunColumn::total_mass);
+    f.orbital.symmetric_mass_ratio = at(RunColumn::symmetric_mass_ratio);
+    f.orbital.chirp_mass = at(RunColumn::chirp_mass);
+    f.orbital.energy = at(RunColumn::energy);
+    f.orbital.angular_momentum = at(RunColumn::angular_momentum);
+
+    f.gw.h_plus = at(RunColumn::h_plus);
+    f.gw.h_cross = at(RunColumn::h_cross);
+    f.gw.amplitude = at(RunColumn::gw_amplitude);
+    f.gw.frequency = at(RunColumn::gw_frequency);
+    return f;
+}
+
+// ============================================================================
+// CollisionTimelineView
+// ============================================================================
+
+CollisionRenderData CollisionTimelineView::frame(size_t i) const
+{
+    return CollisionRenderData::from_frame(run_.frame(i));
+}
+
+CollisionRenderData CollisionTimelineView::interpolate(float t) const
+{
+    // Same search and blend as CollisionTimeline::interpolate(), on the
+    // float frame times it would have stored
+    if (size() == 0) {
+        return CollisionRenderData{};
+    }
+
+    t = std::max(0.0f, std::min(t, total_duration));
+    return interpolate_from(find_frame(t), t);
+}
+
+size_t CollisionTimelineView::find_frame(float t) const
+{
+    size_t n = size();
+    size_t lo = 0, hi = n < 2 ? 0 : n - 2;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (frame_time(mid) <= t) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+CollisionRenderData CollisionTimelineView::interpolate_from(size_t lo, float t) const
+{
+    size_t hi = std::min(lo + 1, size() - 1);
+    if (lo == hi || t <= frame_time(lo)) {
+        return frame(lo);
+    }
+    if (t >= frame_time(hi)) {
+        return frame(hi);
+    }
+
+    float t_lo = frame_time(lo);
+    float alpha = (t - t_lo) / (frame_time(hi) - t_lo);
+    alpha = std::max(0.0f, std::min(1.0f, alpha));
+
+    return CollisionRenderData::blend(frame(lo), frame(hi), t, alpha);
+}
+
+bool load_run(const std::string& filename, CollisionTimelineView& view, std::string* error)
+{
+    BH_TRACE_SCOPE("load_run");
+    MappedRun run;
+    if (!run.open(filename)) {
+        if (error) *error = run.error();
+        return false;
+    }
+
+    view.run_ = std::move(run);
+    view.merger_time = (float)view.run_.summary().merger_time;
+    view.merger_frame_index = -1;
+    view.total_duration = 0;
+
+    size_t n = view.size();
+    if (n == 0) {
+        view.merger_time = 0;
+        return true;
+    }
+    view.total_duration = view.frame_time(n - 1);
+
+    // Phase never decreases along a run, so the merger frame is the first
+    // with phase >= 1 if that one has phase 1. A binary search touches a
+    // few pages instead of the whole column.
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (view.run_.value(mid, RunColumn::phase) < 1.0) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < n && view.run_.value(lo, RunColumn::phase) == 1.0) {
+        view.merger_frame_index = (int)lo;
+    }
+    return true;
+}
+
+} // namespace bh
@@ -5,9 +5,16 @@
  */
 
 #include "bh_collision/simulation.h"
+#include "bh_collision/frame_sink.h"
+#include "bh_collision/json_writer.h"
+#include "bh_collision/sweep.h"
 #include "bh_collision/physics.h"
 #include "bh_collision/integrator.h"
 #include "bh_collision/merger.h"
+#include "bh_collision/pn_kernel.h"
+#include "bh_collision/secular.h"
+#include "bh_collision/compiler.h"
+#include "bh_collision/trace.h"
 
 #include <cmath>
 #include <cstdio>
@@ -15,15 +22,43 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
 
 namespace bh {
 
+// ============================================================================
+// Run statistics
+// ============================================================================
+
+/// Wall-clock timer for SimulationStats; reads 0 with BH_ENABLE_STATS=0
+class StatsTimer {
+public:
+#if BH_ENABLE_STATS
+    StatsTimer() : start_(Clock::now()) {}
+
+    double seconds() const
+    {
+        return std::chrono::duration<double>(Clock::now() - start_).count();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start_;
+#else
+    double seconds() const { return 0.0; }
+#endif
+};
+
+/// make_frame() calls timed: one in MAKE_FRAME_SAMPLE. A clock read costs
+/// about a tenth of a frame.
+constexpr long long MAKE_FRAME_SAMPLE = 16;
+
 // ============================================================================
 // Initialize a binary system from configuration
 // ============================================================================
 
-static void init_binary(const BinaryConfig& config,
-                        BlackHole& bh1, BlackHole& bh2)
+void init_binary(const BinaryConfig& config,
+                 BlackHole& bh1, BlackHole& bh2)
 {
     double M = config.m1 + config.m2;
     double r0 = config.initial_separation;
@@ -62,36 +97,90 @@ static void init_binary(const BinaryConfig& config,
 }
 
 // ============================================================================
-// Build the derivative function for the integrator
+// Derivative functors for the integrator
+//
+// Concrete types rather than a DerivativeFunc, so the templated steppers
+// inline the PN kernel into their stage loop. The enabled PN orders are
+// template parameters (see pn_kernel.h), chosen once per run.
 // ============================================================================
 
-static DerivativeFunc make_deriv_func(double m1, double m2,
-                                       bool pn1, bool pn2, bool pn25)
-{
-    return [m1, m2, pn1, pn2, pn25](const BinaryState& state) -> BinaryStateDerivative {
+/// Equations of motion for the two-body state (12 components)
+template <typename Order>
+struct BinaryEquationsOfMotion {
+    PNCoefficients coeffs;
+
+    BH_FORCEINLINE BinaryStateDerivative operator()(const BinaryState& state) const {
         BinaryStateDerivative d;
 
         // Relative coordinate
         glm::dvec3 r = state.pos1 - state.pos2;
         glm::dvec3 v = state.vel1 - state.vel2;
-        double M = m1 + m2;
 
         // Compute relative acceleration (PN)
-        AccelerationResult acc = compute_relative_acceleration(
-            r, v, m1, m2, pn1, pn2, pn25
-        );
-        glm::dvec3 a_rel = acc.total();
+        glm::dvec3 a_rel = pn_relative_acceleration<
+            Order::enable_1pn, Order::enable_2pn, Order::enable_25pn>(r, v, coeffs);
 
         // Convert to individual accelerations:
         // a1 = (m2/M) * a_rel
         // a2 = -(m1/M) * a_rel
         d.dpos1 = state.vel1;
-        d.dvel1 = (m2 / M) * a_rel;
+        d.dvel1 = coeffs.m2_over_M * a_rel;
         d.dpos2 = state.vel2;
-        d.dvel2 = -(m1 / M) * a_rel;
+        d.dvel2 = -coeffs.m1_over_M * a_rel;
 
         return d;
-    };
+    }
+};
+
+/// Equations of motion for the reduced relative state (6 components):
+/// dr/dt = v, dv/dt = a_rel
+template <typename Order>
+struct RelativeEquationsOfMotion {
+    PNCoefficients coeffs;
+
+    BH_FORCEINLINE RelativeStateDerivative operator()(const RelativeState& state) const {
+        return { state.v,
+                 pn_relative_acceleration<
+                     Order::enable_1pn, Order::enable_2pn, Order::enable_25pn>(
+                     state.r, state.v, coeffs) };
+    }
+};
+
+// ============================================================================
+// Copy the integrator state onto the black holes
+// ============================================================================
+
+static void sync_black_holes(const BinaryState& state, const PNCoefficients&,
+                             BlackHole& bh1, BlackHole& bh2)
+{
+    bh1.position = state.pos1;
+    bh1.velocity = state.vel1;
+    bh2.position = state.pos2;
+    bh2.velocity = state.vel2;
+}
+
+/// Reconstruct the bodies from the relative coordinate, with the center of
+/// mass at rest at the origin (as set up by init_binary)
+static void sync_black_holes(const RelativeState& state, const PNCoefficients& coeffs,
+                             BlackHole& bh1, BlackHole& bh2)
+{
+    bh1.position = coeffs.m2_over_M * state.r;
+    bh1.velocity = coeffs.m2_over_M * state.v;
+    bh2.position = -coeffs.m1_over_M * state.r;
+    bh2.velocity = -coeffs.m1_over_M * state.v;
+}
+
+/// Orbital phase of the relative separation, as compute_orbital_params()
+/// measures it
+static double orbital_phase_of(const BinaryState& state)
+{
+    glm::dvec3 r = state.pos1 - state.pos2;
+    return std::atan2(r.z, r.x);
+}
+
+static double orbital_phase_of(const RelativeState& state)
+{
+    return std::atan2(state.r.z, state.r.x);
 }
 
 // ============================================================================
@@ -112,57 +201,182 @@ static SimulationFrame make_frame(
     return frame;
 }
 
+/// make_frame() counted in stats, and timed one call in MAKE_FRAME_SAMPLE
+static SimulationFrame make_frame(
+    double time, const BlackHole& bh1, const BlackHole& bh2,
+    double obs_distance, double obs_inclination, int phase,
+    SimulationStats& stats)
+{
+#if BH_ENABLE_STATS
+    if (stats.make_frame_calls++ % MAKE_FRAME_SAMPLE == 0) {
+        StatsTimer timer;
+        SimulationFrame frame = make_frame(time, bh1, bh2, obs_distance, obs_inclination, phase);
+        stats.make_frame_seconds += timer.seconds();
+        return frame;
+    }
+#else
+    stats.make_frame_calls++;
+#endif
+    return make_frame(time, bh1, bh2, obs_distance, obs_inclination, phase);
+}
+
+/// Recording bookkeeping carried from the secular phase into the PN phase
+struct RecordingProgress {
+    double next_record_time;
+    double last_phase;        // Orbital phase at the end of the last step
+};
+
 // ============================================================================
-// Main simulation loop
+// PHASE 0: SECULAR FAST-FORWARD (optional)
+// Evolves the orbit-averaged Peters-Mathews equations (see secular.h) until
+// the hand-off separation or velocity, recording frames on the Keplerian
+// orbit in between. Returns the relative state the PN integration resumes
+// from, at the same orbital phase.
 // ============================================================================
 
-SimulationResult run_simulation(const SimulationConfig& config)
+static RelativeState run_secular(
+    const SimulationConfig& config,
+    const PNCoefficients& coeffs,
+    double estimated_merger_time,
+    const RelativeState& start,
+    const RecordingPolicy& recording,
+    BlackHole& bh1, BlackHole& bh2,
+    RecordingProgress& progress,
+    FrameSink& sink,
+    SimulationResult& result)
 {
-    SimulationResult result = {};
-    result.config = config.binary;
-    result.merger_occurred = false;
-    result.merger_time = 0.0;
-    result.total_gw_cycles = 0.0;
+    double M = coeffs.M;
+    SecularState s = secular_from_relative(start, M);
+    SecularRates rates = secular_rates(s, coeffs.eta, M);
+    double start_phase = s.phase;
+    long long step_count = 0;
 
-    // Initialize the binary
-    BlackHole bh1, bh2;
-    init_binary(config.binary, bh1, bh2);
+    while (!secular_should_handoff(s, config.secular, M) && s.time < config.max_time) {
+        double dt = config.secular.step_fraction * s.a / std::abs(rates.da);
+        dt = std::min(dt, config.max_time - s.time);
+
+        SecularState next = secular_step(s, dt, coeffs.eta, M);
+        SecularRates next_rates = secular_rates(next, coeffs.eta, M);
+
+        // Record the frames due in this step, placed on the osculating orbit
+        while (progress.next_record_time < next.time) {
+            double t = std::max(progress.next_record_time, s.time);
+            SecularState at = secular_interpolate(s, rates, next, next_rates, t);
+            sync_black_holes(relative_from_secular(at, M), coeffs, bh1, bh2);
+
+            SimulationFrame frame = make_frame(t, bh1, bh2,
+                                               config.observer_distance, config.observer_inclination, 0,
+                                               result.stats);
+            sink.push(frame);
+            progress.next_record_time = recording.next_time(frame);
+            if (!(progress.next_record_time > t)) progress.next_record_time = next.time;
+        }
 
-    // Get initial orbital parameters for time estimate
-    OrbitalParams initial_orbit = compute_orbital_params(bh1, bh2);
-    double estimated_merger_time = time_to_merger_estimate(
-        initial_orbit.symmetric_mass_ratio,
-        initial_orbit.total_mass,
-        initial_orbit.separation
-    );
+        if (config.progress_callback && step_count % 1000 == 0) {
+            double frac = std::min(1.0, s.time / estimated_merger_time);
+            config.progress_callback(s.time, frac, "secular");
+        }
 
-    // Build integrator state
-    BinaryState state;
-    state.pos1 = bh1.position;
-    state.vel1 = bh1.velocity;
-    state.pos2 = bh2.position;
-    state.vel2 = bh2.velocity;
-    state.time = 0.0;
-
-    auto deriv = make_deriv_func(
-        bh1.mass, bh2.mass,
-        config.enable_1pn, config.enable_2pn, config.enable_25pn
-    );
+        s = next;
+        rates = next_rates;
+        step_count++;
+    }
+
+    // GW = 2x orbital; counted from the phase directly rather than from frames
+    result.total_gw_cycles += (s.phase - start_phase) / M_PI;
+    result.stats.secular_steps += step_count;
+
+    RelativeState handoff = relative_from_secular(s, M);
+    progress.last_phase = std::atan2(handoff.r.z, handoff.r.x);
+    sync_black_holes(handoff, coeffs, bh1, bh2);
+    return handoff;
+}
+
+// Record every frame due before step_end from the dense output of the step
+// just taken. Returns the next record time.
+// Kept out of line so the stepping loop stays small; it runs on a small
+// fraction of steps.
+template <typename State, typename StateDerivative>
+BH_NOINLINE static double record_dense_frames(
+    const SimulationConfig& config,
+    const BasicDenseOutput<State, StateDerivative>& dense,
+    const PNCoefficients& coeffs,
+    const RecordingPolicy& recording,
+    double step_end,
+    double next_record_time,
+    BlackHole& bh1, BlackHole& bh2,
+    FrameSink& sink,
+    SimulationResult& result)
+{
+    while (next_record_time < step_end) {
+        double t = next_record_time;
+        sync_black_holes(dense_evaluate(dense, t), coeffs, bh1, bh2);
+
+        SimulationFrame frame = make_frame(t, bh1, bh2,
+                                           config.observer_distance, config.observer_inclination, 0,
+                                           result.stats);
+        sink.push(frame);
+
+        // The policy picks the next frame time; one it places too early
+        // goes to the end of this step
+        next_record_time = recording.next_time(frame);
+        if (!(next_record_time > t)) next_record_time = step_end;
+    }
+    return next_record_time;
+}
+
+// ============================================================================
+// PHASE 1: INSPIRAL
+// Integrates the PN equations of motion until merger, max_time or the step
+// limit. Templated on the state type (BinaryState or RelativeState) and on
+// the derivative, so the stepper can inline it.
+//
+// Kept out of line: with all eight PN specializations inlined into
+// run_simulation, the compiler runs out of inlining budget for the stage
+// loop itself and the specialization gains are lost.
+// ============================================================================
+
+template <typename State, typename Deriv>
+BH_NOINLINE static void run_inspiral(
+    const SimulationConfig& config,
+    const Deriv& deriv,
+    double estimated_merger_time,
+    const RecordingPolicy& recording,
+    State& state_io,
+    BlackHole& bh1_io, BlackHole& bh2_io,
+    RecordingProgress& progress,
+    FrameSink& sink,
+    SimulationResult& result)
+{
+    // Work on locals so the compiler can keep them in registers across steps
+    State state = state_io;
+    BlackHole bh1 = bh1_io, bh2 = bh2_io;
 
     double total_mass = bh1.mass + bh2.mass;
-    double last_record_time = -config.record_interval;
-    double last_phase = 0.0;
+    double last_phase = progress.last_phase;
+    double phase_swept = 0.0;
+    double next_record_time = progress.next_record_time;
     long long step_count = 0;
 
-    // ========================================================================
-    // PHASE 1: INSPIRAL
-    // ========================================================================
+    // Both steppers carry the derivative at the current state from one step
+    // to the next: Dormand-Prince as its FSAL stage, RK4 as the end-point
+    // slope of its Hermite dense output. Error-controlled stepping also
+    // carries its step size.
+    using StateDerivative = decltype(deriv(state));
+    bool use_dopri5 = config.integrator.method == IntegratorMethod::DormandPrince54;
+    double dt_next = config.integrator.dt_initial;
+    StateDerivative k_first = deriv(state);
+    long long evaluations = 1, rejected = 0;
+    double min_dt = INFINITY, max_dt = 0.0;
+
+    // Continuous extension of the last accepted step. Frames are evaluated
+    // from it at their exact times, so the recording cadence does not
+    // constrain the step size.
+    BasicDenseOutput<State, StateDerivative> dense;
+
     while (state.time < config.max_time) {
         // Update BH states from integrator state
-        bh1.position = state.pos1;
-        bh1.velocity = state.vel1;
-        bh2.position = state.pos2;
-        bh2.velocity = state.vel2;
+        sync_black_holes(state, deriv.coeffs, bh1, bh2);
 
         // Check merger condition
         if (should_merge(bh1, bh2)) {
@@ -170,82 +384,229 @@ SimulationResult run_simulation(const SimulationConfig& config)
             result.merger_time = state.time;
 
             // Record the merger frame
-            result.frames.push_back(
+            sink.push(
                 make_frame(state.time, bh1, bh2,
-                          config.observer_distance, config.observer_inclination, 1)
+                          config.observer_distance, config.observer_inclination, 1,
+                          result.stats)
             );
             break;
         }
 
-        // Adaptive recording interval: fast capture during plunge
-        double current_sep = glm::length(state.pos1 - state.pos2);
-        double M_tot = bh1.mass + bh2.mass;
-        double effective_interval = config.record_interval;
-        
-        if (current_sep < 10.0 * M_tot) {
-             effective_interval = config.record_interval / 4000.0; // High fidelity plunge (4000x)
-        }
-
-        // Record frame at intervals
-        if (state.time - last_record_time >= effective_interval) {
-            result.frames.push_back(
-                make_frame(state.time, bh1, bh2,
-                          config.observer_distance, config.observer_inclination, 0)
-            );
-            last_record_time = state.time;
-
-            // Track GW cycles via phase
-            OrbitalParams orb = compute_orbital_params(bh1, bh2);
-            double phase_diff = orb.orbital_phase - last_phase;
-            // Handle phase wrapping
-            if (phase_diff < -M_PI) phase_diff += 2.0 * M_PI;
-            if (phase_diff > M_PI) phase_diff -= 2.0 * M_PI;
-            result.total_gw_cycles += std::abs(phase_diff) / M_PI;  // GW = 2x orbital
-            last_phase = orb.orbital_phase;
-        }
-
         // Progress callback
         if (config.progress_callback && step_count % 10000 == 0) {
             double frac = std::min(1.0, state.time / estimated_merger_time);
             config.progress_callback(state.time, frac, "inspiral");
         }
 
-        // Adaptive time step
-        double dt = adaptive_timestep(state, config.integrator, total_mass);
-
-        // RK4 step
-        state = rk4_step(state, dt, deriv);
+        if (use_dopri5) {
+            auto step = dopri5_step(
+                state, k_first, dt_next, deriv, config.integrator, &dense
+            );
+            state = step.state;
+            k_first = step.deriv_end;
+            dt_next = step.dt_next;
+            evaluations += step.evaluations;
+            rejected += step.rejected;
+#if BH_ENABLE_STATS
+            min_dt = std::min(min_dt, step.dt_taken);
+            max_dt = std::max(max_dt, step.dt_taken);
+#endif
+        } else {
+            // Adaptive time step
+            double dt = adaptive_timestep(state, config.integrator, total_mass);
+
+            // RK4 step; the Hermite interpolant is only built when a frame
+            // falls inside the step
+            State next = rk4_step(state, k_first, dt, deriv);
+            StateDerivative k_next = deriv(next);
+            if (next_record_time < next.time) {
+                dense = hermite_dense_output(state, k_first, next, k_next);
+            }
+            state = next;
+            k_first = k_next;
+            evaluations += 4;
+#if BH_ENABLE_STATS
+            min_dt = std::min(min_dt, dt);
+            max_dt = std::max(max_dt, dt);
+#endif
+        }
         step_count++;
 
+        // GW cycles from the phase swept by every accepted step, so the
+        // count does not depend on where the recording policy puts frames.
+        // Steps are far shorter than half an orbit, so one unwrap suffices.
+        double phase = orbital_phase_of(state);
+        double phase_diff = phase - last_phase;
+        if (phase_diff < -M_PI) phase_diff += 2.0 * M_PI;
+        if (phase_diff > M_PI) phase_diff -= 2.0 * M_PI;
+        phase_swept += std::abs(phase_diff);
+        last_phase = phase;
+
+        // Record the frames that fall inside this step
+        if (next_record_time < state.time) {
+            next_record_time = record_dense_frames(
+                config, dense, deriv.coeffs, recording, state.time, next_record_time,
+                bh1, bh2, sink, result
+            );
+        }
+
         // Safety: bail if we've done too many steps
         if (step_count > 2000000000) {
             break;
         }
     }
 
-    result.num_inspiral_frames = (int)result.frames.size();
+    sync_black_holes(state, deriv.coeffs, bh1, bh2);
+    state_io = state;
+    bh1_io = bh1;
+    bh2_io = bh2;
+    progress.next_record_time = next_record_time;
+    progress.last_phase = last_phase;
+    result.total_gw_cycles += phase_swept / M_PI;   // GW = 2x orbital
+    result.stats.integrator_steps += step_count;
+    result.stats.rejected_steps += rejected;
+    result.stats.derivative_evaluations += evaluations;
+    if (max_dt > 0.0) {
+        result.stats.min_dt = min_dt;
+        result.stats.max_dt = max_dt;
+    }
+}
+
+// ============================================================================
+// Main simulation loop
+// ============================================================================
+
+// Counts the frames each phase records, whatever the caller's sink keeps
+struct CountingFrameSink final : FrameSink {
+    FrameSink& next;
+    long long count = 0;
+
+    explicit CountingFrameSink(FrameSink& target) : next(target) {}
+
+    void push(const SimulationFrame& frame) override {
+        next.push(frame);
+        count++;
+    }
+};
+
+SimulationResult run_simulation(const SimulationConfig& config)
+{
+    VectorFrameSink frames;
+    SimulationResult result = run_simulation(config, frames);
+    result.frames = std::move(frames.frames);
+    return result;
+}
+
+SimulationResult run_simulation(const SimulationConfig& config, FrameSink& output)
+{
+    BH_TRACE_SCOPE("run_simulation");
+    CountingFrameSink sink(output);
+    StatsTimer total_timer;
+
+    SimulationResult result = {};
+    result.config = config.binary;
+    result.merger_occurred = false;
+    result.merger_time = 0.0;
+    result.total_gw_cycles = 0.0;
+
+    // Initialize the binary
+    BlackHole bh1, bh2;
+    init_binary(config.binary, bh1, bh2);
+
+    // Get initial orbital parameters for time estimate
+    OrbitalParams initial_orbit = compute_orbital_params(bh1, bh2);
+    double estimated_merger_time = time_to_merger_estimate(
+        initial_orbit.symmetric_mass_ratio,
+        initial_orbit.total_mass,
+        initial_orbit.separation
+    );
+
+    // Mass-ratio coefficients are constant for the whole run
+    PNCoefficients coeffs = make_pn_coefficients(bh1.mass, bh2.mass);
+
+    // The first frame is at t = 0; the policy places the rest
+    PlungeRefinedRecording classic_recording(config.record_interval);
+    const RecordingPolicy& recording = config.recording ? *config.recording : classic_recording;
+    RecordingProgress progress = { 0.0, initial_orbit.orbital_phase };
+    double start_time = 0.0;
+
+    // Skip the early inspiral with the orbit-averaged equations
+    if (config.secular.enabled) {
+        BH_TRACE_SCOPE("secular");
+        StatsTimer secular_timer;
+        RelativeState start;
+        start.r = bh1.position - bh2.position;
+        start.v = bh1.velocity - bh2.velocity;
+        start.time = 0.0;
+
+        start_time = run_secular(config, coeffs, estimated_merger_time, start, recording,
+                                 bh1, bh2, progress, sink, result).time;
+        result.stats.secular_seconds = secular_timer.seconds();
+    }
+
+    StatsTimer inspiral_timer;
+    dispatch_pn_order(
+        config.enable_1pn, config.enable_2pn, config.enable_25pn,
+        [&](auto order) {
+            using Order = decltype(order);
+            BH_TRACE_SCOPE("inspiral");
+
+            if (config.integrator.relative_coordinates) {
+                // Build reduced integrator state (COM frame)
+                RelativeState state;
+                state.r = bh1.position - bh2.position;
+                state.v = bh1.velocity - bh2.velocity;
+                state.time = start_time;
+
+                RelativeEquationsOfMotion<Order> deriv{ coeffs };
+                run_inspiral(config, deriv, estimated_merger_time, recording,
+                             state, bh1, bh2, progress, sink, result);
+            } else {
+                // Build integrator state
+                BinaryState state;
+                state.pos1 = bh1.position;
+                state.vel1 = bh1.velocity;
+                state.pos2 = bh2.position;
+                state.vel2 = bh2.velocity;
+                state.time = start_time;
+
+                BinaryEquationsOfMotion<Order> deriv{ coeffs };
+                run_inspiral(config, deriv, estimated_merger_time, recording,
+                             state, bh1, bh2, progress, sink, result);
+            }
+        }
+    );
+    result.stats.inspiral_seconds = inspiral_timer.seconds();
+    result.num_inspiral_frames = (int)sink.count;
 
     // ========================================================================
     // PHASE 2: MERGER → REMNANT
     // ========================================================================
     if (result.merger_occurred) {
-        result.remnant = compute_remnant(bh1, bh2);
-        result.total_energy_radiated = result.remnant.energy_radiated;
-
-        // Get GW amplitude at merger for ringdown matching
-        GWStrain merger_gw = compute_gw_strain(
-            bh1, bh2, config.observer_distance, config.observer_inclination
-        );
-        double merger_amplitude = merger_gw.amplitude * config.observer_distance;
+        StatsTimer merger_timer;
+        {
+            BH_TRACE_SCOPE("merger");
+            result.remnant = compute_remnant(bh1, bh2);
+            result.total_energy_radiated = result.remnant.energy_radiated;
+
+            // Get GW amplitude at merger for ringdown matching
+            GWStrain merger_gw = compute_gw_strain(
+                bh1, bh2, config.observer_distance, config.observer_inclination
+            );
+            double merger_amplitude = merger_gw.amplitude * config.observer_distance;
 
-        // Compute QNM parameters
-        result.qnm = compute_qnm_222(
-            result.remnant.mass, result.remnant.spin, merger_amplitude
-        );
+            // Compute QNM parameters
+            result.qnm = compute_qnm_222(
+                result.remnant.mass, result.remnant.spin, merger_amplitude
+            );
+        }
+        result.stats.merger_seconds = merger_timer.seconds();
 
         // ====================================================================
         // PHASE 3: RINGDOWN
         // ====================================================================
+        BH_TRACE_SCOPE("ringdown");
+        StatsTimer ringdown_timer;
         double ringdown_dt = config.ringdown_duration / config.ringdown_samples;
 
         for (int i = 0; i < config.ringdown_samples; i++) {
@@ -277,7 +638,7 @@ SimulationResult run_simulation(const SimulationConfig& config)
             frame.gw = gw_ring;
             frame.phase = (gw_ring.amplitude > 1e-30) ? 2 : 3;
 
-            result.frames.push_back(frame);
+            sink.push(frame);
 
             if (config.progress_callback && i % 50 == 0) {
                 double frac = (double)i / config.ringdown_samples;
@@ -286,8 +647,20 @@ SimulationResult run_simulation(const SimulationConfig& config)
         }
 
         result.num_ringdown_frames = config.ringdown_samples;
+        result.stats.ringdown_seconds = ringdown_timer.seconds();
+    }
+
+    // Scale the sampled make_frame() time to all calls
+    long long timed_calls = (result.stats.make_frame_calls + MAKE_FRAME_SAMPLE - 1) / MAKE_FRAME_SAMPLE;
+    if (timed_calls > 0) {
+        result.stats.make_frame_seconds *= (double)result.stats.make_frame_calls / (double)timed_calls;
     }
+    result.stats.frames_recorded = sink.count;
 
+    // The sink sees the time up to its finish(); the caller's copy includes it
+    result.stats.total_seconds = total_timer.seconds();
+    output.finish(result);
+    result.stats.total_seconds = total_timer.seconds();
     return result;
 }
 
@@ -295,95 +668,69 @@ SimulationResult run_simulation(const SimulationConfig& config)
 // JSON export
 // ============================================================================
 
-bool export_to_json(const SimulationResult& result, const std::string& filename)
+/// Format the elements of the "frames" array in slices of chunk frames on
+/// the executor, a few slices per thread at a time, and write them to out
+/// in order. Each slice is formatted as it would be in the middle of the
+/// array, so the text matches a single writer's.
+static void write_json_frames_parallel(std::ostream& out,
+                                       const std::vector<SimulationFrame>& frames,
+                                       size_t chunk, bool compact, Executor& executor)
+{
+    size_t num_chunks = (frames.size() + chunk - 1) / chunk;
+    size_t batch = std::max<size_t>(4 * (size_t)executor.concurrency(), 1);
+    std::vector<std::string> slices(batch);
+
+    for (size_t first = 0; first < num_chunks; first += batch) {
+        size_t count = std::min(batch, num_chunks - first);
+
+        executor.parallel_for(count, [&](size_t k) {
+            size_t c = first + k;
+            JsonWriter slice(compact);
+            slice.text().swap(slices[k]);     // Reuse last round's capacity
+            slice.text().clear();
+            slice.continue_array(2, c > 0);   // Inside root -> "frames"
+            size_t end = std::min(frames.size(), (c + 1) * chunk);
+            for (size_t i = c * chunk; i < end; i++) {
+                detail::write_json_frame(slice, frames[i]);
+            }
+            slice.text().swap(slices[k]);
+        });
+
+        for (size_t k = 0; k < count; k++) {
+            out.write(slices[k].data(), (std::streamsize)slices[k].size());
+        }
+    }
+}
+
+bool export_to_json(const SimulationResult& result, const std::string& filename,
+                    const ExportOptions& options)
 {
+    BH_TRACE_SCOPE("export_to_json");
     std::ofstream out(filename);
     if (!out.is_open()) return false;
 
-    out << std::setprecision(12);
-    out << "{\n";
-
-    // Metadata
-    out << "  \"metadata\": {\n";
-    out << "    \"units\": \"geometrized (G=c=1)\",\n";
-    out << "    \"mass_unit\": \"total_mass_M\",\n";
-    out << "    \"length_unit\": \"M\",\n";
-    out << "    \"time_unit\": \"M\",\n";
-    out << "    \"num_frames\": " << result.frames.size() << ",\n";
-    out << "    \"merger_occurred\": " << (result.merger_occurred ? "true" : "false") << ",\n";
-    out << "    \"merger_time\": " << result.merger_time << ",\n";
-    out << "    \"total_gw_cycles\": " << result.total_gw_cycles << ",\n";
-    out << "    \"energy_radiated_fraction\": " << result.total_energy_radiated << "\n";
-    out << "  },\n";
-
-    // Config
-    out << "  \"config\": {\n";
-    out << "    \"m1\": " << result.config.m1 << ",\n";
-    out << "    \"m2\": " << result.config.m2 << ",\n";
-    out << "    \"chi1\": " << result.config.chi1 << ",\n";
-    out << "    \"chi2\": " << result.config.chi2 << ",\n";
-    out << "    \"initial_separation\": " << result.config.initial_separation << ",\n";
-    out << "    \"eccentricity\": " << result.config.eccentricity << "\n";
-    out << "  },\n";
-
-    // Remnant
-    if (result.merger_occurred) {
-        out << "  \"remnant\": {\n";
-        out << "    \"mass\": " << result.remnant.mass << ",\n";
-        out << "    \"spin\": " << result.remnant.spin << ",\n";
-        out << "    \"kick_velocity\": " << result.remnant.kick_velocity << ",\n";
-        out << "    \"energy_radiated\": " << result.remnant.energy_radiated << ",\n";
-        out << "    \"position\": [" << result.remnant.position.x << ", "
-            << result.remnant.position.y << ", " << result.remnant.position.z << "],\n";
-        out << "    \"qnm_frequency\": " << result.qnm.frequency << ",\n";
-        out << "    \"qnm_damping_time\": " << result.qnm.damping_time << "\n";
-        out << "  },\n";
-    }
+    JsonWriter json(out, options.compact);
+    json.begin_object();
+
+    // Metadata, config and remnant
+    detail::write_json_summary(json, result, result.frames.size());
 
     // Frames
-    out << "  \"frames\": [\n";
-    for (size_t i = 0; i < result.frames.size(); i++) {
-        const auto& f = result.frames[i];
-        out << "    {\n";
-        out << "      \"time\": " << f.time << ",\n";
-        out << "      \"phase\": " << f.phase << ",\n";
-
-        out << "      \"bh1\": {\n";
-        out << "        \"mass\": " << f.bh1.mass << ",\n";
-        out << "        \"position\": [" << f.bh1.position.x << ", "
-            << f.bh1.position.y << ", " << f.bh1.position.z << "],\n";
-        out << "        \"velocity\": [" << f.bh1.velocity.x << ", "
-            << f.bh1.velocity.y << ", " << f.bh1.velocity.z << "]\n";
-        out << "      },\n";
-
-        out << "      \"bh2\": {\n";
-        out << "        \"mass\": " << f.bh2.mass << ",\n";
-        out << "        \"position\": [" << f.bh2.position.x << ", "
-            << f.bh2.position.y << ", " << f.bh2.position.z << "],\n";
-        out << "        \"velocity\": [" << f.bh2.velocity.x << ", "
-            << f.bh2.velocity.y << ", " << f.bh2.velocity.z << "]\n";
-        out << "      },\n";
-
-        out << "      \"orbital\": {\n";
-        out << "        \"separation\": " << f.orbital.separation << ",\n";
-        out << "        \"frequency\": " << f.orbital.orbital_frequency << ",\n";
-        out << "        \"energy\": " << f.orbital.energy << "\n";
-        out << "      },\n";
-
-        out << "      \"gw\": {\n";
-        out << "        \"h_plus\": " << f.gw.h_plus << ",\n";
-        out << "        \"h_cross\": " << f.gw.h_cross << ",\n";
-        out << "        \"amplitude\": " << f.gw.amplitude << ",\n";
-        out << "        \"frequency\": " << f.gw.frequency << "\n";
-        out << "      }\n";
-
-        out << "    }" << (i + 1 < result.frames.size() ? "," : "") << "\n";
+    json.begin_array("frames");
+    size_t chunk = std::max<size_t>(options.chunk_frames, 1);
+    if (options.executor && options.executor->concurrency() > 1 && result.frames.size() > chunk) {
+        json.flush();
+        write_json_frames_parallel(out, result.frames, chunk, options.compact, *options.executor);
+    } else {
+        for (const auto& f : result.frames) {
+            detail::write_json_frame(json, f);
+        }
     }
-    out << "  ]\n";
+    json.end_array();
 
-    out << "}\n";
-    out.close();
-    return true;
+    json.end_object();
+    json.raw("\n");
+    return json.flush();
 }
 
 // ============================================================================
@@ -415,11 +762,34 @@ void print_summary(const SimulationResult& result)
     printf("  Chirp mass M_c = %.4f M\n\n", chirp);
 
     printf("Simulation Statistics:\n");
-    printf("  Total frames recorded: %zu\n", result.frames.size());
+    printf("  Total frames recorded: %d\n",
+           result.num_inspiral_frames + result.num_ringdown_frames);
     printf("  Inspiral frames: %d\n", result.num_inspiral_frames);
     printf("  Ringdown frames: %d\n", result.num_ringdown_frames);
+    printf("  Integrator steps: %lld (%lld rejected), %lld derivative evaluations\n",
+           result.stats.integrator_steps, result.stats.rejected_steps,
+           result.stats.derivative_evaluations);
+    if (result.stats.secular_steps > 0) {
+        printf("  Fast-forward steps: %lld\n", result.stats.secular_steps);
+    }
     printf("  Total GW cycles: %.1f\n\n", result.total_gw_cycles);
 
+#if BH_ENABLE_STATS
+    const SimulationStats& stats = result.stats;
+    printf("Timing:\n");
+    printf("  Step size: %.3e .. %.3e M\n", stats.min_dt, stats.max_dt);
+    if (stats.secular_steps > 0) {
+        printf("  Fast-forward: %8.3f s\n", stats.secular_seconds);
+    }
+    printf("  Inspiral:     %8.3f s\n", stats.inspiral_seconds);
+    printf("  Merger:       %8.3f s\n", stats.merger_seconds);
+    printf("  Ringdown:     %8.3f s\n", stats.ringdown_seconds);
+    printf("  Total:        %8.3f s\n", stats.total_seconds);
+    printf("  make_frame:   %8.3f s over %lld frames (%.0f ns each)\n\n",
+           stats.make_frame_seconds, stats.make_frame_calls,
+           stats.make_frame_calls > 0 ? 1e9 * stats.make_frame_seconds / stats.make_frame_calls : 0.0);
+#endif
+
     if (result.merger_occurred) {
         printf("Merger:\n");
         printf("  Merger time = %.2f M\n", result.merger_time);
@@ -0,0 +1,168 @@
+/**
+ * @file sweep.cpp
+ * @brief Executors and the parameter-sweep runner.
+ */
+
+#include "bh_collision/sweep.h"
+#include "bh_collision/frame_sink.h"
+
+namespace bh {
+
+// ============================================================================
+// SerialExecutor
+// ============================================================================
+
+void SerialExecutor::parallel_for(size_t count, const std::function<void(size_t)>& task)
+{
+    for (size_t i = 0; i < count; i++) {
+        task(i);
+    }
+}
+
+// ============================================================================
+// WorkStealingExecutor
+// ============================================================================
+
+WorkStealingExecutor::WorkStealingExecutor(unsigned num_threads)
+{
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 1;
+
+    for (unsigned i = 0; i < num_threads; i++) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned i = 0; i < num_threads; i++) {
+        threads_.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+void WorkStealingExecutor::parallel_for(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0) return;
+
+    std::lock_guard<std::mutex> call_lock(call_mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &task;
+    remaining_ = count;
+
+    // Contiguous blocks keep neighbouring grid points on one worker; stealing
+    // evens out blocks that turn out slower than the rest
+    size_t n = queues_.size();
+    for (size_t w = 0; w < n; w++) {
+        std::lock_guard<std::mutex> queue_lock(queues_[w]->mutex);
+        for (size_t i = w * count / n; i < (w + 1) * count / n; i++) {
+            queues_[w]->tasks.push_back(i);
+        }
+    }
+    generation_++;
+    wake_.notify_all();
+
+    done_.wait(lock, [this] { return remaining_ == 0; });
+    task_ = nullptr;
+}
+
+bool WorkStealingExecutor::pop_or_steal(unsigned id, size_t& index)
+{
+    // Own queue first, from the front
+    {
+        WorkQueue& own = *queues_[id];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            index = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // Then the other queues, from the back
+    size_t n = queues_.size();
+    for (size_t k = 1; k < n; k++) {
+        WorkQueue& victim = *queues_[(id + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            index = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingExecutor::worker_loop(unsigned id)
+{
+    unsigned long long seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+        }
+
+        size_t index;
+        while (pop_or_steal(id, index)) {
+            // Read the task after the pop: a worker still draining one
+            // parallel_for may pick up the first index of the next
+            const std::function<void(size_t)>* task;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                task = task_;
+            }
+            (*task)(index);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--remaining_ == 0) done_.notify_all();
+        }
+    }
+}
+
+// ============================================================================
+// Sweep runner
+// ============================================================================
+
+/// Drops every frame; the run still counts them
+class DiscardFrameSink : public FrameSink {
+public:
+    void push(const SimulationFrame&) override {}
+};
+
+std::vector<SimulationResult> run_sweep(
+    const std::vector<SimulationConfig>& configs,
+    Executor& executor,
+    const SweepCallback& on_result,
+    bool keep_frames)
+{
+    std::vector<SimulationResult> results(configs.size());
+    std::mutex callback_mutex;
+
+    executor.parallel_for(configs.size(), [&](size_t i) {
+        SimulationResult result;
+        if (keep_frames) {
+            result = run_simulation(configs[i]);
+        } else {
+            DiscardFrameSink discard;
+            result = run_simulation(configs[i], discard);
+        }
+
+        if (on_result) {
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            on_result(i, result);
+        }
+        results[i] = std::move(result);
+    });
+
+    return results;
+}
+
+} // namespace bh
@@ -0,0 +1,155 @@
+/**
+ * @file trace.cpp
+ * @brief Per-thread span buffers and the trace-event JSON writer.
+ */
+
+#include "bh_collision/trace.h"
+#include "bh_collision/json_writer.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace bh {
+
+namespace detail {
+std::atomic<bool> trace_on{ false };
+}
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+// A thread's spans go into a list of fixed-size chunks. Only the owning
+// thread writes; it publishes each span by a release store of the count
+// and each new chunk by a release store of next, so write_trace() can read
+// the filled part at any time without stopping the thread.
+constexpr size_t TRACE_CHUNK_EVENTS = 4096;
+
+struct TraceChunk {
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+    std::atomic<size_t> count{ 0 };
+    std::atomic<TraceChunk*> next{ nullptr };
+};
+
+struct ThreadTrace {
+    int tid = 0;
+    TraceChunk head;
+    TraceChunk* tail = &head;   // Owning thread only
+
+    ThreadTrace() = default;
+    ThreadTrace(const ThreadTrace&) = delete;
+    ThreadTrace& operator=(const ThreadTrace&) = delete;
+
+    ~ThreadTrace()
+    {
+        TraceChunk* c = head.next.load(std::memory_order_acquire);
+        while (c) {
+            TraceChunk* next = c->next.load(std::memory_order_acquire);
+            delete c;
+            c = next;
+        }
+    }
+};
+
+// Buffers live until the process exits, so a thread's spans outlive it
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadTrace>> threads;
+};
+
+TraceRegistry& registry()
+{
+    static TraceRegistry r;
+    return r;
+}
+
+std::atomic<uint64_t> trace_epoch_ns{ 0 };
+thread_local ThreadTrace* this_thread_trace = nullptr;
+
+ThreadTrace& thread_trace()
+{
+    if (!this_thread_trace) {
+        TraceRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(std::make_unique<ThreadTrace>());
+        r.threads.back()->tid = (int)r.threads.size();
+        this_thread_trace = r.threads.back().get();
+    }
+    return *this_thread_trace;
+}
+
+} // namespace
+
+void trace_start()
+{
+    trace_epoch_ns.store(detail::trace_now_ns(), std::memory_order_relaxed);
+    detail::trace_on.store(true, std::memory_order_relaxed);
+}
+
+void trace_stop()
+{
+    detail::trace_on.store(false, std::memory_order_relaxed);
+}
+
+void detail::trace_record(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+    ThreadTrace& t = thread_trace();
+    TraceChunk* c = t.tail;
+    size_t n = c->count.load(std::memory_order_relaxed);
+    if (n == TRACE_CHUNK_EVENTS) {
+        TraceChunk* fresh = new TraceChunk;
+        c->next.store(fresh, std::memory_order_release);
+        t.tail = c = fresh;
+        n = 0;
+    }
+    c->events[n] = { name, start_ns, end_ns };
+    c->count.store(n + 1, std::memory_order_release);
+}
+
+bool write_trace(const std::string& filename)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) return false;
+
+    uint64_t epoch = trace_epoch_ns.load(std::memory_order_relaxed);
+
+    JsonWriter json(out, true);
+    json.begin_object();
+    json.begin_array("traceEvents");
+    {
+        TraceRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& thread : r.threads) {
+            for (const TraceChunk* c = &thread->head; c; c = c->next.load(std::memory_order_acquire)) {
+                size_t n = c->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < n; i++) {
+                    const TraceEvent& e = c->events[i];
+                    if (e.start_ns < epoch) continue;
+
+                    // Complete event; times in microseconds from trace_start()
+                    json.begin_object();
+                    json.string("name", e.name);
+                    json.string("cat", "bh");
+                    json.string("ph", "X");
+                    json.number("pid", 1LL);
+                    json.number("tid", (long long)thread->tid);
+                    json.number("ts", (double)(e.start_ns - epoch) * 1e-3);
+                    json.number("dur", (double)(e.end_ns - e.start_ns) * 1e-3);
+                    json.end_object();
+                }
+            }
+        }
+    }
+    json.end_array();
+    json.string("displayTimeUnit", "ms");
+    json.end_object();
+    return json.flush();
+}
+
+} // namespace bh
@@ -6,6 +6,20 @@
  *   - Ray-marched metaball rendering for merging black holes
  *   - Gravitational Wave Ripple Grid (Vertex displacement shader)
  *   - Mouse drag to orbit camera, scroll to zoom
+ *
+ * Usage:
+ *   bh_viewer [--m1 <m>] [--m2 <m>] [--sep <a>] [--save <file.bhrun>] [--tolerance <M>]
+ *   bh_viewer --load <file.bhrun>
+ *   (either form also takes --trace <file.json>)
+ *
+ * --load maps a saved run instead of simulating, so the window opens at once.
+ * --tolerance sets how far (in M) the played-back orbits may stray from the
+ * simulated ones when the timeline drops redundant inspiral frames
+ * (default 1e-3; 0 keeps every frame).
+ * --trace writes a Chrome trace-event timeline of the setup and of every
+ * rendered frame (interpolate, raymarch pass, grid pass, swap) on exit.
+ * GL calls return before the GPU is done, so GPU-bound stalls show up in
+ * swap rather than in the pass that caused them.
  */
 
 #include <GL/glew.h>
@@ -16,12 +30,17 @@
 
 #include "bh_collision/simulation.h"
 #include "bh_collision/integration_api.h"
+#include "bh_collision/mapped_run.h"
+#include "bh_collision/run_file.h"
+#include "bh_collision/trace.h"
 
 #include <cstdio>
+#include <cstring>
 #include <cmath>
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <functional>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -562,23 +581,62 @@ int main(int argc, char** argv) {
     sim_config.integrator.safety_factor = 2.5e-7; 
     sim_config.integrator.dt_min = 1e-10;           
     sim_config.integrator.dt_max = 0.1; 
+    sim_config.integrator.relative_coordinates = true;
     
     // Post-merger extension: ~3 seconds of ringdown
     sim_config.ringdown_duration = 1400.0; 
     sim_config.ringdown_samples = 1500; 
 
+    std::string load_file, save_file, trace_file;
+    float position_tolerance = 1e-3f;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--m1") == 0 && i + 1 < argc) sim_config.binary.m1 = atof(argv[++i]);
         else if (strcmp(argv[i], "--m2") == 0 && i + 1 < argc) sim_config.binary.m2 = atof(argv[++i]);
         else if (strcmp(argv[i], "--sep") == 0 && i + 1 < argc) sim_config.binary.initial_separation = atof(argv[++i]);
+        else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) load_file = argv[++i];
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) save_file = argv[++i];
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) position_tolerance = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) trace_file = argv[++i];
     }
     double M_total = sim_config.binary.m1 + sim_config.binary.m2;
     sim_config.binary.m1 /= M_total; sim_config.binary.m2 /= M_total;
-
-    printf("  Running simulation...\n");
-    bh::SimulationResult result = bh::run_simulation(sim_config);
-    bh::CollisionTimeline timeline = bh::CollisionTimeline::build(result);
-    printf("  Timeline: %.1f M, %zu frames\n", timeline.total_duration, timeline.frames.size());
+    if (!trace_file.empty()) bh::trace_start();
+
+    // Playback reads either a timeline built from a fresh run or a view over
+    // a mapped .bhrun file, through a cursor that follows the playback time
+    bh::CollisionTimeline timeline;
+    bh::CollisionTimelineView loaded;
+    std::function<bh::CollisionRenderData(float)> sample;
+    float total_duration;
+
+    if (!load_file.empty()) {
+        std::string error;
+        if (!bh::load_run(load_file, loaded, &error)) {
+            printf("  ERROR: Failed to load %s: %s\n", load_file.c_str(), error.c_str());
+            return 1;
+        }
+        sample = [cursor = bh::TimelineCursor<bh::CollisionTimelineView>(loaded)](float t) mutable {
+            return cursor.interpolate(t);
+        };
+        total_duration = loaded.total_duration;
+        printf("  Loaded %s\n", load_file.c_str());
+        printf("  Timeline: %.1f M, %zu frames\n", loaded.total_duration, loaded.size());
+    } else {
+        printf("  Running simulation...\n");
+        bh::SimulationResult result = bh::run_simulation(sim_config);
+        if (!save_file.empty()) {
+            if (bh::write_run(save_file, result)) printf("  Saved run to %s\n", save_file.c_str());
+            else printf("  ERROR: Failed to save %s\n", save_file.c_str());
+        }
+        timeline = bh::CollisionTimeline::build(result, position_tolerance);
+        timeline.build_time_index();
+        sample = [cursor = bh::TimelineCursor<bh::CollisionTimeline>(timeline)](float t) mutable {
+            return cursor.interpolate(t);
+        };
+        total_duration = timeline.total_duration;
+        printf("  Timeline: %.1f M, %zu of %zu frames\n", timeline.total_duration,
+               timeline.frames.size(), result.frames.size());
+    }
 
     if (!glfwInit()) return 1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -617,6 +675,7 @@ int main(int argc, char** argv) {
     float last_time = (float)glfwGetTime();
 
     while (!glfwWindowShouldClose(window)) {
+        BH_TRACE_SCOPE("frame");
         glfwPollEvents();
         float now = (float)glfwGetTime();
         float dt = std::min(now - last_time, 0.05f);
@@ -625,7 +684,11 @@ int main(int argc, char** argv) {
         process_held_keys(window, dt);
         if (!g_paused) {
             // Compute current separation for adaptive speed
-            bh::CollisionRenderData current_frame = timeline.interpolate(g_playback_time);
+            bh::CollisionRenderData current_frame;
+            {
+                BH_TRACE_SCOPE("interpolate");
+                current_frame = sample(g_playback_time);
+            }
             float separation = 100.0f;
             if (current_frame.num_black_holes == 2) {
                  separation = glm::length(current_frame.black_holes[0].position - current_frame.black_holes[1].position);
@@ -651,11 +714,15 @@ int main(int argc, char** argv) {
             
             g_playback_time += dt * current_speed_val * g_playback_speed;
         }
-        if (g_playback_time > timeline.total_duration) {
+        if (g_playback_time > total_duration) {
             g_playback_time = 0.0f; 
         }
 
-        bh::CollisionRenderData frame = timeline.interpolate(g_playback_time);
+        bh::CollisionRenderData frame;
+        {
+            BH_TRACE_SCOPE("interpolate");
+            frame = sample(g_playback_time);
+        }
 
         float yaw_rad = glm::radians(g_cam_yaw);
         float pitch_rad = glm::radians(g_cam_pitch);
@@ -667,12 +734,18 @@ int main(int argc, char** argv) {
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glDisable(GL_DEPTH_TEST);
-        draw_black_holes_raymarched(frame, cam_pos, g_cam_target, 45.0f);
-        glEnable(GL_DEPTH_TEST);
+        {
+            BH_TRACE_SCOPE("raymarch");
+            glDisable(GL_DEPTH_TEST);
+            draw_black_holes_raymarched(frame, cam_pos, g_cam_target, 45.0f);
+            glEnable(GL_DEPTH_TEST);
+        }
 
         // Draw Ripple Grid
-        draw_grid_ripple(vp, g_playback_time, timeline.total_duration, frame.gw_amplitude, frame.gw_frequency);
+        {
+            BH_TRACE_SCOPE("grid");
+            draw_grid_ripple(vp, g_playback_time, total_duration, frame.gw_amplitude, frame.gw_frequency);
+        }
 
         if (frame.num_black_holes == 2) {
              glm::vec3 com = (frame.black_holes[0].position * frame.black_holes[0].mass +
@@ -681,8 +754,11 @@ int main(int argc, char** argv) {
              draw_sphere(com, 0.15f, {1.0f, 1.0f, 0.5f}, 0.3f, view, proj);
         }
 
-        update_title(window, frame, timeline.total_duration, g_playback_speed);
-        glfwSwapBuffers(window);
+        update_title(window, frame, total_duration, g_playback_speed);
+        {
+            BH_TRACE_SCOPE("swap");
+            glfwSwapBuffers(window);
+        }
     }
 
     glDeleteProgram(g_prog_raymarch);
@@ -690,5 +766,11 @@ int main(int argc, char** argv) {
     glDeleteProgram(g_prog_grid);
     glfwDestroyWindow(window);
     glfwTerminate();
+
+    if (!trace_file.empty()) {
+        bh::trace_stop();
+        if (bh::write_trace(trace_file)) printf("  Trace written to %s\n", trace_file.c_str());
+        else printf("  ERROR: Failed to write %s\n", trace_file.c_str());
+    }
     return 0;
 }
@@ -9,16 +9,64 @@
  *   4. Merger detection
  *   5. Remnant properties (equal-mass non-spinning)
  *   6. QNM ringdown damping
+ *   7. Kepler orbital frequency
+ *   8. PN energy loss rate is negative
+ *   9. Time-to-merger estimate
+ *  10. Gravitational recoil kick
+ *  11. Error-controlled Dormand-Prince 5(4) stepping
+ *  12. Templated steppers agree with the std::function overloads
+ *  13. Compile-time PN kernels agree with the runtime-flag reference
+ *  14. Reduced relative-coordinate integration matches the two-body state
+ *  15. Batched SoA engine reproduces single-binary inspirals
+ *  16. Secular (Peters-Mathews) fast-forward and hand-off
+ *  17. Dense output interpolates inside steps; frames land on exact times
+ *  18. Frame sinks receive the same frames run_simulation() stores
+ *  19. Columnar frame storage round-trips and records from a sink
+ *  20. Work-stealing parameter sweep matches serial runs
+ *  21. Binary run files (.bhrun) round-trip and reject bad input
+ *  22. Memory-mapped timeline view matches CollisionTimeline; damaged runs
+ *      are rejected
+ *  23. JSON writer layout, number round-trip, compact and parallel export
+ *  24. Async frame sink delivers in order with bounded backlog
+ *  25. Timeline cursor and time index agree with the binary search
+ *  26. Hermite playback keeps orbits round; thinned timelines stay in tolerance
+ *  27. Error-bounded decimation rebuilds every dropped frame within tolerance
+ *  28. Recording policies place inspiral frames where they ask
+ *  29. Work counters match each integrator's evaluations per step; timers
+ *      and step-size extremes are consistent
+ *  30. Trace spans are written per thread, only while tracing is on
  */
 
 #include "bh_collision/physics.h"
 #include "bh_collision/integrator.h"
 #include "bh_collision/merger.h"
 #include "bh_collision/simulation.h"
+#include "bh_collision/pn_kernel.h"
+#include "bh_collision/batch.h"
+#include "bh_collision/secular.h"
+#include "bh_collision/frame_sink.h"
+#include "bh_collision/columnar.h"
+#include "bh_collision/sweep.h"
+#include "bh_collision/run_file.h"
+#include "bh_collision/mapped_run.h"
+#include "bh_collision/integration_api.h"
+#include "bh_collision/json_writer.h"
+#include "bh_collision/trace.h"
 
 #include <cstdio>
 #include <cmath>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 static int tests_passed = 0;
 static int tests_failed = 0;
@@ -48,6 +96,22 @@ static int tests_failed = 0;
         return; \
     }
 
+// ============================================================================
+// Shared run setup
+// ============================================================================
+
+/// A short DP54 run in relative coordinates from 12 M, the setup most of
+/// the frame, file and timeline tests share; override fields as needed
+static bh::SimulationConfig short_dp54_config() {
+    bh::SimulationConfig config;
+    config.binary.initial_separation = 12.0;
+    config.record_interval = 5.0;
+    config.ringdown_samples = 40;
+    config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    config.integrator.relative_coordinates = true;
+    return config;
+}
+
 // ============================================================================
 // Test 1: Newtonian orbit stability
 // ============================================================================
@@ -327,6 +391,1291 @@ void test_recoil_kick() {
     PASS();
 }
 
+// ============================================================================
+// Test 11: Dormand-Prince 5(4) error control
+// ============================================================================
+void test_dopri5_error_control() {
+    TEST("DP54 conserves energy with far fewer steps than RK4");
+
+    bh::BlackHole bh1, bh2;
+    bh1.mass = 0.5; bh1.chi = 0.0;
+    bh2.mass = 0.5; bh2.chi = 0.0;
+
+    double r0 = 20.0;
+    bh1.position = glm::dvec3(10.0, 0.0, 0.0);
+    bh2.position = glm::dvec3(-10.0, 0.0, 0.0);
+
+    double v_circ = std::sqrt(1.0 / r0);
+    bh1.velocity = glm::dvec3(0.0, 0.0, v_circ * 0.5);
+    bh2.velocity = glm::dvec3(0.0, 0.0, -v_circ * 0.5);
+
+    double E0 = bh::compute_orbital_params(bh1, bh2).energy;
+
+    bh::BinaryState state;
+    state.pos1 = bh1.position; state.vel1 = bh1.velocity;
+    state.pos2 = bh2.position; state.vel2 = bh2.velocity;
+
+    bh::DerivativeFunc deriv = [](const bh::BinaryState& s) -> bh::BinaryStateDerivative {
+        bh::AccelerationResult acc = bh::compute_relative_acceleration(
+            s.pos1 - s.pos2, s.vel1 - s.vel2, 0.5, 0.5, false, false, false
+        );
+        glm::dvec3 a_rel = acc.total();
+        bh::BinaryStateDerivative d;
+        d.dpos1 = s.vel1;
+        d.dvel1 = 0.5 * a_rel;
+        d.dpos2 = s.vel2;
+        d.dvel2 = -0.5 * a_rel;
+        return d;
+    };
+
+    bh::IntegratorConfig cfg;
+    cfg.abs_tol = 1e-12;
+    cfg.rel_tol = 1e-12;
+    cfg.dt_max = 100.0;
+
+    // Start with an oversized step to force at least one rejection
+    double orbital_period = 2.0 * M_PI * std::sqrt(r0 * r0 * r0);
+    double dt = 50.0;
+    int steps = 0, rejected = 0;
+    bh::BinaryStateDerivative k1 = deriv(state);
+    while (state.time < orbital_period) {
+        bh::AdaptiveStepResult step = bh::dopri5_step(
+            state, k1, std::min(dt, orbital_period - state.time), deriv, cfg);
+        ASSERT_TRUE(step.error_norm <= 1.0, "Accepted step exceeds tolerance");
+        state = step.state;
+        k1 = step.deriv_end;
+        dt = step.dt_next;
+        rejected += step.rejected;
+        steps++;
+    }
+
+    bh1.position = state.pos1; bh1.velocity = state.vel1;
+    bh2.position = state.pos2; bh2.velocity = state.vel2;
+    double dE = std::abs(bh::compute_orbital_params(bh1, bh2).energy - E0) / std::abs(E0);
+
+    ASSERT_TRUE(rejected > 0, "Oversized first step should be rejected");
+    ASSERT_TRUE(dE < 1e-8, "Energy conservation violated");
+    // Test 1 needs ~56000 RK4 steps for 1e-6
+    ASSERT_TRUE(steps < 2000, "Too many steps for a single Newtonian orbit");
+    PASS();
+}
+
+// ============================================================================
+// Test 12: Templated stepper matches std::function overload
+// ============================================================================
+void test_templated_stepper() {
+    TEST("Inlined RK4 path is bit-identical to DerivativeFunc");
+
+    auto lambda = [](const bh::BinaryState& s) -> bh::BinaryStateDerivative {
+        bh::AccelerationResult acc = bh::compute_relative_acceleration(
+            s.pos1 - s.pos2, s.vel1 - s.vel2, 0.6, 0.4, true, true, true
+        );
+        glm::dvec3 a_rel = acc.total();
+        bh::BinaryStateDerivative d;
+        d.dpos1 = s.vel1;
+        d.dvel1 = 0.4 * a_rel;
+        d.dpos2 = s.vel2;
+        d.dvel2 = -0.6 * a_rel;
+        return d;
+    };
+    bh::DerivativeFunc erased = lambda;
+
+    bh::BinaryState a;
+    a.pos1 = glm::dvec3(6.0, 0.0, 0.0);  a.vel1 = glm::dvec3(0.0, 0.0, 0.1);
+    a.pos2 = glm::dvec3(-9.0, 0.0, 0.0); a.vel2 = glm::dvec3(0.0, 0.0, -0.15);
+    bh::BinaryState b = a;
+
+    for (int i = 0; i < 1000; i++) {
+        a = bh::rk4_step(a, 0.1, lambda);
+        b = bh::rk4_step(b, 0.1, erased);
+    }
+
+    ASSERT_TRUE(a.pos1 == b.pos1 && a.vel1 == b.vel1 &&
+                a.pos2 == b.pos2 && a.vel2 == b.vel2, "States differ");
+    ASSERT_CLOSE(a.time, 100.0, 1e-9, "Time after 1000 steps");
+    PASS();
+}
+
+// ============================================================================
+// Test 13: Specialized PN kernels match the reference implementation
+// ============================================================================
+void test_pn_kernel_specializations() {
+    TEST("PN kernel specializations match runtime flags");
+
+    // Eccentric-ish, unequal-mass configuration so every term is non-zero
+    glm::dvec3 r(7.0, 0.5, -2.0);
+    glm::dvec3 v(0.05, 0.01, 0.3);
+    double m1 = 0.7, m2 = 0.3;
+
+    for (int mask = 0; mask < 8; mask++) {
+        bool pn1 = mask & 1, pn2 = mask & 2, pn25 = mask & 4;
+        glm::dvec3 expected = bh::compute_relative_acceleration(
+            r, v, m1, m2, pn1, pn2, pn25).total();
+        glm::dvec3 got = bh::dispatch_pn_order(pn1, pn2, pn25, [&](auto order) {
+            using O = decltype(order);
+            return bh::pn_relative_acceleration<
+                O::enable_1pn, O::enable_2pn, O::enable_25pn>(r, v, m1, m2);
+        });
+        ASSERT_CLOSE(glm::length(got - expected), 0.0,
+                     1e-15 * glm::length(expected), "Kernel mismatch");
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 14: Relative-coordinate state reproduces the two-body trajectories
+// ============================================================================
+void test_relative_state() {
+    TEST("Relative-coordinate state matches two-body state");
+
+    double m1 = 0.6, m2 = 0.4;
+    bh::PNCoefficients c = bh::make_pn_coefficients(m1, m2);
+
+    auto full_deriv = [&](const bh::BinaryState& s) -> bh::BinaryStateDerivative {
+        glm::dvec3 a_rel = bh::pn_relative_acceleration<true, true, true>(
+            s.pos1 - s.pos2, s.vel1 - s.vel2, c);
+        return { s.vel1, c.m2_over_M * a_rel, s.vel2, -c.m1_over_M * a_rel };
+    };
+    auto rel_deriv = [&](const bh::RelativeState& s) -> bh::RelativeStateDerivative {
+        return { s.v, bh::pn_relative_acceleration<true, true, true>(s.r, s.v, c) };
+    };
+
+    // Circular orbit at r = 12 M in the COM frame
+    double r0 = 12.0;
+    double v_rel = std::sqrt(1.0 / r0);
+    bh::BinaryState full;
+    full.pos1 = glm::dvec3(r0 * m2, 0.0, 0.0);  full.vel1 = glm::dvec3(0.0, 0.0, v_rel * m2);
+    full.pos2 = glm::dvec3(-r0 * m1, 0.0, 0.0); full.vel2 = glm::dvec3(0.0, 0.0, -v_rel * m1);
+    bh::RelativeState rel;
+    rel.r = full.pos1 - full.pos2;
+    rel.v = full.vel1 - full.vel2;
+
+    // About two orbits of RK4 with radiation reaction
+    for (int i = 0; i < 5000; i++) {
+        full = bh::rk4_step(full, 0.1, full_deriv);
+        rel = bh::rk4_step(rel, 0.1, rel_deriv);
+    }
+
+    ASSERT_CLOSE(glm::length(c.m2_over_M * rel.r - full.pos1), 0.0, 1e-9, "BH1 position differs");
+    ASSERT_CLOSE(glm::length(-c.m1_over_M * rel.r - full.pos2), 0.0, 1e-9, "BH2 position differs");
+    ASSERT_CLOSE(glm::length(c.m2_over_M * rel.v - full.vel1), 0.0, 1e-9, "BH1 velocity differs");
+    ASSERT_CLOSE(rel.time, full.time, 1e-12, "Time differs");
+
+    // The full simulation in relative mode reaches the same merger
+    bh::SimulationConfig config;
+    config.binary.m1 = m1;
+    config.binary.m2 = m2;
+    config.binary.initial_separation = r0;
+    config.record_interval = 50.0;
+    config.ringdown_samples = 10;
+    config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    config.integrator.dt_max = 1.0;
+
+    bh::SimulationResult a = bh::run_simulation(config);
+    config.integrator.relative_coordinates = true;
+    bh::SimulationResult b = bh::run_simulation(config);
+
+    ASSERT_TRUE(a.merger_occurred && b.merger_occurred, "Both runs should merge");
+    ASSERT_CLOSE(b.merger_time, a.merger_time, 1e-5 * a.merger_time, "Merger times differ");
+    PASS();
+}
+
+// ============================================================================
+// Test 15: Batched engine matches run_simulation per binary
+// ============================================================================
+void test_inspiral_batch() {
+    TEST("Batched inspirals match run_simulation");
+
+    // More configurations than lanes, so lanes retire and refill
+    std::vector<bh::SimulationConfig> configs;
+    for (int i = 0; i < 2 * BH_BATCH_WIDTH + 3; i++) {
+        bh::SimulationConfig c;
+        double q = 0.4 + 0.03 * i;
+        c.binary.m1 = 1.0 / (1.0 + q);
+        c.binary.m2 = q / (1.0 + q);
+        c.binary.initial_separation = 9.0 + 0.25 * i;
+        c.record_interval = 1e9;
+        c.ringdown_samples = 1;
+        c.integrator.safety_factor = 0.01;
+        c.integrator.dt_max = 0.5;
+        c.integrator.relative_coordinates = true;
+        configs.push_back(c);
+    }
+    // A fixed-step lane, and a lane without radiation reaction that runs out of time
+    configs[3].integrator.adaptive = false;
+    configs[3].integrator.dt_initial = 0.05;
+    configs[5].enable_25pn = false;
+    configs[5].max_time = 200.0;
+
+    std::vector<bh::BatchInspiralResult> batch = bh::run_inspiral_batch(configs);
+    ASSERT_TRUE(batch.size() == configs.size(), "One result per configuration");
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        bh::SimulationResult ref = bh::run_simulation(configs[i]);
+        ASSERT_TRUE(batch[i].merger_occurred == ref.merger_occurred, "Merger outcome differs");
+        if (ref.merger_occurred) {
+            ASSERT_CLOSE(batch[i].merger_time, ref.merger_time, 1e-9 * ref.merger_time,
+                         "Merger time differs");
+            ASSERT_CLOSE(batch[i].remnant.mass, ref.remnant.mass, 1e-12, "Remnant mass differs");
+        } else {
+            ASSERT_TRUE(batch[i].merger_time >= configs[i].max_time, "Lane retired early");
+        }
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 16: Secular fast-forward
+// ============================================================================
+void test_secular_fast_forward() {
+    TEST("Secular evolution and hand-off match PN inspiral");
+
+    // Circular decay has a closed form: a(t) = a0 (1 - t/tau)^(1/4),
+    // phase(t) = (8/5) tau n0 [1 - (1 - t/tau)^(5/8)]
+    double M = 1.0, eta = 0.25, a0 = 50.0;
+    double tau = std::pow(a0, 4.0) / (4.0 * 64.0 / 5.0 * eta * M * M * M);
+    double n0 = std::sqrt(M / (a0 * a0 * a0));
+
+    bh::SecularState s = { a0, 0.0, 0.0, 0.0, 0.0 };
+    while (s.a > 20.0) {
+        bh::SecularRates r = bh::secular_rates(s, eta, M);
+        s = bh::secular_step(s, 1e-3 * s.a / std::abs(r.da), eta, M);
+    }
+    double x = 1.0 - s.time / tau;
+    ASSERT_CLOSE(s.a, a0 * std::pow(x, 0.25), 1e-9 * a0, "Semi-major axis off");
+    ASSERT_CLOSE(s.phase, 1.6 * tau * n0 * (1.0 - std::pow(x, 0.625)), 1e-6,
+                 "Orbital phase off");
+
+    // Keplerian conversion round-trips on an eccentric orbit
+    bh::SecularState k = { 30.0, 0.3, 2.0, 0.4, 0.0 };
+    bh::SecularState back = bh::secular_from_relative(bh::relative_from_secular(k, M), M);
+    ASSERT_CLOSE(back.a, k.a, 1e-10, "Round-trip a");
+    ASSERT_CLOSE(back.e, k.e, 1e-12, "Round-trip e");
+    ASSERT_CLOSE(back.phase, k.phase, 1e-10, "Round-trip phase");
+    ASSERT_CLOSE(back.periapsis, k.periapsis, 1e-10, "Round-trip periapsis");
+
+    // With Newtonian dynamics plus 2.5PN radiation reaction the secular
+    // equations are the orbit average of the integrated ones
+    bh::SimulationConfig config;
+    config.binary.initial_separation = 20.0;
+    config.enable_1pn = false;
+    config.enable_2pn = false;
+    config.record_interval = 5.0;
+    config.ringdown_samples = 1;
+    config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    config.integrator.relative_coordinates = true;
+
+    bh::SimulationResult full = bh::run_simulation(config);
+    config.secular.enabled = true;
+    config.secular.handoff_separation = 14.0;
+    bh::SimulationResult hybrid = bh::run_simulation(config);
+
+    ASSERT_TRUE(full.merger_occurred && hybrid.merger_occurred, "Both runs should merge");
+    ASSERT_CLOSE(hybrid.merger_time, full.merger_time, 1e-4 * full.merger_time,
+                 "Hybrid merger time differs");
+    ASSERT_CLOSE(hybrid.total_gw_cycles, full.total_gw_cycles, 0.05, "GW cycle count differs");
+    PASS();
+}
+
+// ============================================================================
+// Test 17: Dense output
+// ============================================================================
+void test_dense_output() {
+    TEST("Dense output interpolates steps; frames at exact times");
+
+    // Newtonian circular orbit, M = 1, r0 = 20: r(t) = r0 (cos wt, 0, sin wt)
+    double r0 = 20.0;
+    double w = std::sqrt(1.0 / (r0 * r0 * r0));
+    auto deriv = [](const bh::RelativeState& s) -> bh::RelativeStateDerivative {
+        double r = std::sqrt(glm::dot(s.r, s.r));
+        return { s.v, -s.r / (r * r * r) };
+    };
+
+    bh::RelativeState y0;
+    y0.r = glm::dvec3(r0, 0.0, 0.0);
+    y0.v = glm::dvec3(0.0, 0.0, r0 * w);
+    y0.time = 0.0;
+
+    bh::IntegratorConfig cfg;
+    cfg.abs_tol = 1e-10;
+    cfg.rel_tol = 1e-10;
+    cfg.dt_max = 1e3;
+
+    // One accepted step; the interpolant must reproduce its end points and
+    // follow the exact orbit in between to the step's accuracy
+    bh::RelativeDenseOutput dense;
+    bh::RelativeStepResult step = bh::dopri5_step(y0, deriv(y0), 1.0, deriv, cfg, &dense);
+    ASSERT_TRUE(!step.rejected, "Step should be accepted");
+
+    bh::RelativeState end = bh::dense_evaluate(dense, step.state.time);
+    ASSERT_CLOSE(glm::length(end.r - step.state.r), 0.0, 1e-12, "Interpolant misses step end");
+    bh::RelativeState start = bh::dense_evaluate(dense, 0.0);
+    ASSERT_TRUE(start.r == y0.r && start.v == y0.v, "Interpolant misses step start");
+
+    double tm = 0.37 * step.state.time;
+    bh::RelativeState mid = bh::dense_evaluate(dense, tm);
+    glm::dvec3 exact(r0 * std::cos(w * tm), 0.0, r0 * std::sin(w * tm));
+    ASSERT_CLOSE(mid.time, tm, 0.0, "Interpolated time");
+    ASSERT_CLOSE(glm::length(mid.r - exact), 0.0, 1e-9 * r0, "DP54 interpolant off the orbit");
+
+    // The cubic Hermite interpolant used with RK4 is exact for uniform acceleration
+    glm::dvec3 a(0.0, 0.0, -0.3);
+    bh::RelativeState p0 = { glm::dvec3(1.0, 2.0, 3.0), glm::dvec3(0.5, 0.0, 1.0), 2.0 };
+    bh::RelativeState p1 = { p0.r + 4.0 * p0.v + 8.0 * a, p0.v + 4.0 * a, 6.0 };
+    bh::RelativeDenseOutput cubic = bh::hermite_dense_output(
+        p0, bh::RelativeStateDerivative{ p0.v, a }, p1, bh::RelativeStateDerivative{ p1.v, a });
+    bh::RelativeState h = bh::dense_evaluate(cubic, 3.5);
+    ASSERT_CLOSE(glm::length(h.r - (p0.r + 1.5 * p0.v + 1.125 * a)), 0.0, 1e-13, "Hermite position");
+    ASSERT_CLOSE(glm::length(h.v - (p0.v + 1.5 * a)), 0.0, 1e-13, "Hermite velocity");
+
+    // Recorded frames sit on multiples of record_interval regardless of
+    // step size, and the two integrators agree at those times
+    bh::SimulationConfig config;
+    config.binary.initial_separation = 20.0;
+    config.record_interval = 7.3;
+    config.max_time = 2000.0;
+    config.ringdown_samples = 1;
+    config.integrator.relative_coordinates = true;
+    config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    config.integrator.dt_max = 100.0;
+    bh::SimulationResult dp = bh::run_simulation(config);
+
+    config.integrator.method = bh::IntegratorMethod::RK4;
+    config.integrator.safety_factor = 1e-4;
+    config.integrator.dt_max = 1.0;
+    bh::SimulationResult rk = bh::run_simulation(config);
+
+    // The last step may overshoot max_time by a different amount in each run
+    size_t n = std::min(dp.frames.size(), rk.frames.size());
+    ASSERT_TRUE(n > 200, "Too few frames recorded");
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_CLOSE(dp.frames[i].time, rk.frames[i].time, 1e-9, "Frame times differ");
+    }
+    ASSERT_CLOSE(dp.frames[200].time, 200 * 7.3, 1e-9, "Frame off the recording grid");
+    ASSERT_CLOSE(glm::length(dp.frames[200].bh1.position - rk.frames[200].bh1.position),
+                 0.0, 1e-5, "Integrators disagree at a recorded time");
+    PASS();
+}
+
+// ============================================================================
+// Test 18: Streaming frame sinks
+// ============================================================================
+void test_frame_sinks() {
+    TEST("Frame sinks receive the recorded frames in order");
+
+    bh::SimulationConfig config = short_dp54_config();
+
+    bh::SimulationResult stored = bh::run_simulation(config);
+    ASSERT_TRUE(stored.merger_occurred, "Reference run should merge");
+
+    bh::VectorFrameSink vector_sink;
+    bh::SimulationResult streamed = bh::run_simulation(config, vector_sink);
+    ASSERT_TRUE(streamed.frames.empty(), "Streaming run should not store frames");
+    ASSERT_TRUE(vector_sink.frames.size() == stored.frames.size(), "Frame count differs");
+    for (size_t i = 0; i < stored.frames.size(); i++) {
+        ASSERT_TRUE(vector_sink.frames[i].time == stored.frames[i].time &&
+                    vector_sink.frames[i].bh1.position == stored.frames[i].bh1.position,
+                    "Streamed frame differs");
+    }
+    ASSERT_TRUE(streamed.num_inspiral_frames == stored.num_inspiral_frames &&
+                streamed.num_ringdown_frames == stored.num_ringdown_frames,
+                "Frame counters differ");
+    ASSERT_CLOSE(streamed.merger_time, stored.merger_time, 0.0, "Merger time differs");
+
+    // Decimation keeps every 7th inspiral frame and all merger/ringdown frames
+    long long inspiral = 0;
+    for (const auto& f : stored.frames) inspiral += (f.phase == 0);
+    long long expected = (inspiral + 6) / 7 + ((long long)stored.frames.size() - inspiral);
+
+    long long received = 0;
+    double last_time = -1.0;
+    bool ordered = true;
+    bh::CallbackFrameSink counter([&](const bh::SimulationFrame& f) {
+        ordered = ordered && f.time >= last_time;  // merger and first ringdown frame share a time
+        last_time = f.time;
+        received++;
+    });
+    bh::DecimatingFrameSink decimated(counter, 7);
+    bh::run_simulation(config, decimated);
+
+    ASSERT_TRUE(ordered, "Frames out of time order");
+    ASSERT_TRUE(received == expected, "Decimated frame count wrong");
+    PASS();
+}
+
+// ============================================================================
+// Test 19: Columnar frame storage
+// ============================================================================
+void test_columnar_result() {
+    TEST("Columnar result round-trips and matches the sink");
+
+    bh::SimulationConfig config = short_dp54_config();
+
+    bh::SimulationResult result = bh::run_simulation(config);
+    bh::ColumnarResult columnar = bh::to_columnar(result);
+    bh::SimulationResult back = bh::to_result(columnar);
+
+    ASSERT_TRUE(columnar.frames.size() == result.frames.size(), "Column length differs");
+    ASSERT_TRUE(back.frames.size() == result.frames.size(), "Round-trip frame count differs");
+    for (size_t i = 0; i < result.frames.size(); i++) {
+        const bh::SimulationFrame& a = result.frames[i];
+        const bh::SimulationFrame& b = back.frames[i];
+        ASSERT_TRUE(a.time == b.time && a.phase == b.phase &&
+                    a.bh1.position == b.bh1.position && a.bh2.velocity == b.bh2.velocity &&
+                    a.bh1.spin_axis == b.bh1.spin_axis && a.bh2.chi == b.bh2.chi &&
+                    a.orbital.angular_momentum == b.orbital.angular_momentum &&
+                    a.orbital.chirp_mass == b.orbital.chirp_mass &&
+                    a.gw.h_cross == b.gw.h_cross && a.gw.frequency == b.gw.frequency,
+                    "Round-trip frame differs");
+    }
+    ASSERT_TRUE(back.merger_occurred == result.merger_occurred &&
+                back.num_inspiral_frames == result.num_inspiral_frames,
+                "Round-trip summary differs");
+    ASSERT_TRUE(back.stats.integrator_steps == result.stats.integrator_steps &&
+                back.stats.derivative_evaluations == result.stats.derivative_evaluations &&
+                back.stats.total_seconds == result.stats.total_seconds,
+                "Round-trip stats differ");
+
+    // Recording straight into columns gives the same arrays
+    bh::ColumnarFrameSink sink;
+    bh::SimulationResult sink_run = bh::run_simulation(config, sink);
+    ASSERT_TRUE(sink.result.frames.h_plus == columnar.frames.h_plus &&
+                sink.result.frames.bh2.position.z == columnar.frames.bh2.position.z,
+                "Sink columns differ");
+    ASSERT_CLOSE(sink.result.merger_time, result.merger_time, 0.0, "Sink merger time");
+    ASSERT_CLOSE(sink.result.qnm.frequency, result.qnm.frequency, 0.0, "Sink QNM frequency");
+    ASSERT_TRUE(sink.result.stats.integrator_steps == result.stats.integrator_steps,
+                "Sink stats differ");
+#if BH_ENABLE_STATS
+    // The sink gets the run time up to its finish(), not zero
+    ASSERT_TRUE(sink.result.stats.total_seconds > 0.0 &&
+                sink.result.stats.total_seconds <= sink_run.stats.total_seconds,
+                "Sink total time wrong");
+#endif
+    PASS();
+}
+
+// ============================================================================
+// Test 20: Parameter sweep on the work-stealing executor
+// ============================================================================
+void test_parameter_sweep() {
+    TEST("Work-stealing sweep matches serial runs");
+
+    // Every index runs exactly once, also across back-to-back calls
+    bh::WorkStealingExecutor executor(4);
+    for (int round = 0; round < 20; round++) {
+        std::vector<std::atomic<int>> hits(997);
+        for (auto& h : hits) h = 0;
+        executor.parallel_for(hits.size(), [&](size_t i) { hits[i]++; });
+        for (const auto& h : hits) {
+            ASSERT_TRUE(h == 1, "Task not run exactly once");
+        }
+    }
+
+    // Callers on other threads take turns instead of overwriting each
+    // other's task
+    {
+        std::vector<std::atomic<int>> hits_a(997), hits_b(997);
+        for (auto& h : hits_a) h = 0;
+        for (auto& h : hits_b) h = 0;
+        std::thread other([&] {
+            for (int round = 0; round < 20; round++) {
+                executor.parallel_for(hits_b.size(), [&](size_t i) { hits_b[i]++; });
+            }
+        });
+        for (int round = 0; round < 20; round++) {
+            executor.parallel_for(hits_a.size(), [&](size_t i) { hits_a[i]++; });
+        }
+        other.join();
+        for (size_t i = 0; i < hits_a.size(); i++) {
+            ASSERT_TRUE(hits_a[i] == 20 && hits_b[i] == 20, "Concurrent callers lost tasks");
+        }
+    }
+
+    // Durations differ by ~4x across the grid
+    std::vector<bh::SimulationConfig> configs;
+    for (double sep : { 10.0, 12.0, 14.0 }) {
+        for (double m1 : { 0.5, 0.7 }) {
+            bh::SimulationConfig config;
+            config.binary.initial_separation = sep;
+            config.binary.m1 = m1;
+            config.binary.m2 = 1.0 - m1;
+            config.record_interval = 5.0;
+            config.ringdown_samples = 10;
+            config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+            config.integrator.relative_coordinates = true;
+            configs.push_back(config);
+        }
+    }
+
+    std::vector<int> callbacks(configs.size(), 0);
+    std::vector<bh::SimulationResult> parallel = bh::run_sweep(
+        configs, executor,
+        [&](size_t i, const bh::SimulationResult& r) {
+            callbacks[i]++;
+            (void)r;
+        });
+    bh::SerialExecutor serial;
+    std::vector<bh::SimulationResult> reference = bh::run_sweep(configs, serial, nullptr, true);
+
+    ASSERT_TRUE(parallel.size() == configs.size(), "Result count differs");
+    for (size_t i = 0; i < configs.size(); i++) {
+        ASSERT_TRUE(callbacks[i] == 1, "Callback not called once per job");
+        ASSERT_TRUE(parallel[i].merger_occurred && reference[i].merger_occurred,
+                    "Sweep run did not merge");
+        ASSERT_CLOSE(parallel[i].merger_time, reference[i].merger_time, 0.0,
+                     "Parallel merger time differs");
+        ASSERT_TRUE(parallel[i].config.initial_separation == configs[i].binary.initial_separation,
+                    "Results out of config order");
+        ASSERT_TRUE(parallel[i].frames.empty(), "Frames kept without keep_frames");
+        ASSERT_TRUE(parallel[i].num_inspiral_frames == (int)reference[i].frames.size()
+                    - reference[i].num_ringdown_frames, "Frame count differs");
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 21: Binary run files
+// ============================================================================
+static std::vector<char> read_bytes(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void test_run_file() {
+    TEST("Run files round-trip through write_run/read_run");
+
+    bh::SimulationConfig config = short_dp54_config();
+    config.binary.chi1 = 0.4;
+
+    bh::SimulationResult result = bh::run_simulation(config);
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string written = (dir / "bh_test_written.bhrun").string();
+    std::string streamed = (dir / "bh_test_streamed.bhrun").string();
+
+    // Small chunks so the file has several, the last one partial
+    const size_t chunk = 64;
+    ASSERT_TRUE(result.frames.size() > 2 * chunk, "Run too short for several chunks");
+    ASSERT_TRUE(bh::write_run(written, result, chunk), "write_run failed");
+
+    bh::RunFileReader reader;
+    ASSERT_TRUE(reader.open(written), "Reader could not open the file");
+    ASSERT_TRUE(reader.layout().chunks.size() == (result.frames.size() + chunk - 1) / chunk,
+                "Chunk count wrong");
+    for (const bh::RunChunk& c : reader.layout().chunks) {
+        ASSERT_TRUE(c.offset % 64 == 0, "Chunk not 64-byte aligned");
+    }
+
+    bh::SimulationResult back;
+    std::string error;
+    ASSERT_TRUE(bh::read_run(written, back, &error), "read_run failed");
+    ASSERT_TRUE(back.frames.size() == result.frames.size(), "Frame count differs");
+    for (size_t i = 0; i < result.frames.size(); i++) {
+        const bh::SimulationFrame& a = result.frames[i];
+        const bh::SimulationFrame& b = back.frames[i];
+        ASSERT_TRUE(a.time == b.time && a.phase == b.phase &&
+                    a.bh1.position == b.bh1.position && a.bh2.velocity == b.bh2.velocity &&
+                    a.bh1.spin_axis == b.bh1.spin_axis && a.bh1.chi == b.bh1.chi &&
+                    a.orbital.separation == b.orbital.separation &&
+                    a.orbital.energy == b.orbital.energy &&
+                    a.gw.h_plus == b.gw.h_plus && a.gw.frequency == b.gw.frequency,
+                    "Frame differs after round trip");
+    }
+    ASSERT_TRUE(back.merger_occurred == result.merger_occurred &&
+                back.num_inspiral_frames == result.num_inspiral_frames &&
+                back.num_ringdown_frames == result.num_ringdown_frames,
+                "Summary differs after round trip");
+    ASSERT_CLOSE(back.merger_time, result.merger_time, 0.0, "Merger time differs");
+    ASSERT_CLOSE(back.remnant.kick_velocity, result.remnant.kick_velocity, 0.0, "Kick differs");
+    ASSERT_CLOSE(back.qnm.damping_time, result.qnm.damping_time, 0.0, "QNM differs");
+    ASSERT_CLOSE(back.config.chi1, 0.4, 0.0, "Config differs");
+
+    // Streaming during the run and writing columns afterwards give the same file
+    {
+        bh::RunFileSink sink(streamed, chunk);
+        ASSERT_TRUE(sink.is_open(), "Sink could not open the file");
+        bh::run_simulation(config, sink);
+        ASSERT_TRUE(sink.complete(), "Sink did not complete the file");
+    }
+    ASSERT_TRUE(bh::write_run(written, bh::to_columnar(result), chunk), "Columnar write failed");
+    std::vector<char> streamed_bytes = read_bytes(streamed);
+    ASSERT_TRUE(!streamed_bytes.empty() && streamed_bytes == read_bytes(written),
+                "Streamed file differs from write_run");
+
+    // Gathering chunks on several threads gives the same file
+    bh::WorkStealingExecutor executor(3);
+    ASSERT_TRUE(bh::write_run(written, result, chunk, &executor), "Parallel write failed");
+    ASSERT_TRUE(read_bytes(written) == streamed_bytes, "Parallel write differs");
+
+    // Truncated and foreign files are rejected with a reason
+    {
+        std::ofstream out(streamed, std::ios::binary | std::ios::trunc);
+        out.write(streamed_bytes.data(), (std::streamsize)(streamed_bytes.size() / 2));
+    }
+    ASSERT_TRUE(!bh::read_run(streamed, back, &error) && !error.empty(), "Truncated file accepted");
+    {
+        std::ofstream out(streamed, std::ios::trunc);
+        out << "{ \"frames\": [] }";
+    }
+    ASSERT_TRUE(!bh::read_run(streamed, back, &error) && !error.empty(), "JSON file accepted");
+
+    std::filesystem::remove(written);
+    std::filesystem::remove(streamed);
+    PASS();
+}
+
+// ============================================================================
+// Test 22: Memory-mapped timeline view
+// ============================================================================
+void test_mapped_timeline() {
+    TEST("Mapped timeline view matches CollisionTimeline");
+
+    bh::SimulationConfig config = short_dp54_config();
+    config.binary.m1 = 0.6;
+    config.binary.m2 = 0.4;
+
+    bh::SimulationResult result = bh::run_simulation(config);
+    std::string path = (std::filesystem::temp_directory_path() / "bh_test_mapped.bhrun").string();
+    ASSERT_TRUE(bh::write_run(path, result, 50), "write_run failed");
+
+    bh::CollisionTimeline timeline = bh::CollisionTimeline::build(result);
+    {
+        bh::CollisionTimelineView view;
+        std::string error;
+        ASSERT_TRUE(bh::load_run(path, view, &error), "load_run failed");
+        ASSERT_TRUE(view.size() == timeline.frames.size(), "Frame count differs");
+        ASSERT_TRUE(view.merger_frame_index == timeline.merger_frame_index, "Merger frame differs");
+        ASSERT_TRUE(view.total_duration == timeline.total_duration &&
+                    view.merger_time == timeline.merger_time, "Timeline times differ");
+
+        // Sample across chunk boundaries, the merger and both clamps
+        int samples = 2000;
+        for (int k = -5; k <= samples + 5; k++) {
+            float t = timeline.total_duration * (float)k / (float)samples;
+            bh::CollisionRenderData a = timeline.interpolate(t);
+            bh::CollisionRenderData b = view.interpolate(t);
+            ASSERT_TRUE(a.time == b.time && a.phase == b.phase &&
+                        a.num_black_holes == b.num_black_holes &&
+                        a.black_holes[0].position == b.black_holes[0].position &&
+                        a.black_holes[1].position == b.black_holes[1].position &&
+                        a.black_holes[0].isco_radius == b.black_holes[0].isco_radius &&
+                        a.gw_strain_plus == b.gw_strain_plus &&
+                        a.gw_amplitude == b.gw_amplitude &&
+                        a.orbital_phase == b.orbital_phase,
+                        "Interpolated render data differs");
+        }
+
+        // A cursor over the view walks to the same frames
+        bh::TimelineCursor<bh::CollisionTimelineView> cursor(view);
+        for (int k = 0; k <= samples; k++) {
+            float t = timeline.total_duration * (float)k / (float)samples;
+            ASSERT_TRUE(cursor.interpolate(t).gw_strain_plus == timeline.interpolate(t).gw_strain_plus,
+                        "View cursor differs");
+        }
+
+        // The view keeps working after a move
+        bh::CollisionTimelineView moved = std::move(view);
+        ASSERT_TRUE(moved.interpolate(moved.merger_time).phase ==
+                    timeline.interpolate(timeline.merger_time).phase, "Moved view differs");
+        ASSERT_CLOSE(moved.run().summary().remnant.mass, result.remnant.mass, 0.0, "Summary differs");
+    }
+
+    // Foreign files are rejected with a reason
+    {
+        std::ofstream out(path, std::ios::trunc);
+        out << "not a run";
+    }
+    bh::CollisionTimelineView bad;
+    std::string error;
+    ASSERT_TRUE(!bh::load_run(path, bad, &error) && !error.empty(), "Bad file accepted");
+
+    // So are damaged runs: both readers fail with a reason instead of
+    // allocating or reading past the end
+    ASSERT_TRUE(bh::write_run(path, result, 1 << 20), "write_run failed");
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    uint64_t index_offset;
+    std::memcpy(&index_offset, bytes.data() + 48, 8);
+
+    auto rejected = [&](const std::vector<char>& damaged) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(damaged.data(), (std::streamsize)damaged.size());
+        }
+        bh::CollisionTimelineView view;
+        bh::ColumnarResult columnar;
+        std::string load_error, read_error;
+        return !bh::load_run(path, view, &load_error) && !load_error.empty() &&
+               !bh::read_run(path, columnar, &read_error) && !read_error.empty();
+    };
+    auto set_u64 = [](std::vector<char>& b, size_t pos, uint64_t v) { std::memcpy(b.data() + pos, &v, 8); };
+
+    // Index cut off
+    std::vector<char> truncated(bytes.begin(), bytes.begin() + (std::ptrdiff_t)index_offset);
+    ASSERT_TRUE(rejected(truncated), "Truncated index accepted");
+
+    // Chunk count far beyond the file
+    std::vector<char> many_chunks = bytes;
+    set_u64(many_chunks, 40, 1ull << 62);
+    ASSERT_TRUE(rejected(many_chunks), "Huge chunk count accepted");
+
+    // 2^61 frames of 39 doubles wrap the chunk's end around to its start
+    std::vector<char> wrapped = bytes;
+    set_u64(wrapped, 24, 1ull << 61);
+    set_u64(wrapped, 32, 1ull << 61);
+    set_u64(wrapped, (size_t)index_offset + 16, 1ull << 61);
+    ASSERT_TRUE(rejected(wrapped), "Wrapped chunk size accepted");
+
+    // A damaged phase column: read_run() rejects the chunk, the mapped view
+    // (which does not scan columns on open) clamps the value
+    uint64_t chunk_offset, chunk_frames;
+    std::memcpy(&chunk_offset, bytes.data() + index_offset, 8);
+    std::memcpy(&chunk_frames, bytes.data() + index_offset + 16, 8);
+    size_t phase_column = (size_t)(chunk_offset + (uint64_t)bh::RunColumn::phase * chunk_frames * 8);
+    for (double damaged_phase : { std::nan(""), -1.0, 1e300 }) {
+        std::vector<char> damaged = bytes;
+        std::memcpy(damaged.data() + phase_column, &damaged_phase, 8);
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(damaged.data(), (std::streamsize)damaged.size());
+        }
+        bh::ColumnarResult columnar;
+        std::string read_error;
+        ASSERT_TRUE(!bh::read_run(path, columnar, &read_error) && !read_error.empty(),
+                    "Damaged phase accepted by read_run");
+
+        bh::CollisionTimelineView view;
+        ASSERT_TRUE(bh::load_run(path, view), "load_run failed on a damaged phase");
+        int phase = view.run().frame(0).phase;
+        ASSERT_TRUE(phase == (damaged_phase > 3.0 ? 3 : 0), "Damaged phase not clamped");
+    }
+
+    std::filesystem::remove(path);
+    PASS();
+}
+
+// ============================================================================
+// Test 23: JSON writer
+// ============================================================================
+void test_json_writer() {
+    TEST("JSON writer: layout, round-trip, compact, parallel");
+
+    // Pretty layout
+    {
+        std::ostringstream out;
+        bh::JsonWriter json(out);
+        json.begin_object();
+        json.string("name", "run");
+        json.begin_object("bh");
+        json.number("mass", 0.5);
+        json.vec3("position", glm::dvec3(1.0, -2.0, 0.25));
+        json.end_object();
+        json.begin_array("empty");
+        json.end_array();
+        json.boolean("merged", true);
+        json.end_object();
+        json.flush();
+        ASSERT_TRUE(out.str() ==
+                    "{\n"
+                    "  \"name\": \"run\",\n"
+                    "  \"bh\": {\n"
+                    "    \"mass\": 0.5,\n"
+                    "    \"position\": [1, -2, 0.25]\n"
+                    "  },\n"
+                    "  \"empty\": [\n"
+                    "  ],\n"
+                    "  \"merged\": true\n"
+                    "}", "Pretty layout differs");
+    }
+
+    // Doubles read back exactly
+    {
+        const double values[] = { 0.1, 1.0 / 3.0, -2.5e21, 5e-324, 1e300, 3012.900511649175, 0.0 };
+        std::ostringstream out;
+        {
+            bh::JsonWriter json(out, true);
+            json.begin_array();
+            for (double v : values) json.number(nullptr, v);
+            json.end_array();
+        }
+        std::string text = out.str();
+        ASSERT_TRUE(text.front() == '[' && text.back() == ']', "Array brackets missing");
+        const char* p = text.c_str() + 1;
+        for (double v : values) {
+            char* end;
+            double back = std::strtod(p, &end);
+            ASSERT_TRUE(back == v, "Number does not round-trip");
+            p = end + 1;
+        }
+    }
+
+    // Compact export is the pretty export without the whitespace
+    bh::SimulationConfig config = short_dp54_config();
+    bh::SimulationResult result = bh::run_simulation(config);
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string pretty_path = (dir / "bh_test_pretty.json").string();
+    std::string compact_path = (dir / "bh_test_compact.json").string();
+    bh::ExportOptions compact;
+    compact.compact = true;
+    ASSERT_TRUE(bh::export_to_json(result, pretty_path), "Pretty export failed");
+    ASSERT_TRUE(bh::export_to_json(result, compact_path, compact), "Compact export failed");
+
+    // Formatting slices on several threads gives the same bytes
+    bh::WorkStealingExecutor executor(3);
+    for (bool compact_mode : { false, true }) {
+        bh::ExportOptions parallel;
+        parallel.compact = compact_mode;
+        parallel.executor = &executor;
+        parallel.chunk_frames = 7;   // Several batches, last slice partial
+        std::string parallel_path = (dir / "bh_test_parallel.json").string();
+        ASSERT_TRUE(result.frames.size() > 4 * 3 * 7 && result.frames.size() % 7 != 0,
+                    "Run too short for several batches");
+        ASSERT_TRUE(bh::export_to_json(result, parallel_path, parallel), "Parallel export failed");
+        ASSERT_TRUE(read_bytes(parallel_path) ==
+                    read_bytes(compact_mode ? compact_path : pretty_path),
+                    "Parallel export differs from serial");
+        std::filesystem::remove(parallel_path);
+    }
+
+    std::vector<char> pretty = read_bytes(pretty_path);
+    std::vector<char> stripped;
+    bool in_string = false;
+    for (char c : pretty) {
+        if (c == '"') in_string = !in_string;
+        if (in_string || (c != ' ' && c != '\n')) stripped.push_back(c);
+    }
+    stripped.push_back('\n');
+    ASSERT_TRUE(stripped == read_bytes(compact_path), "Compact export differs from pretty");
+
+    std::filesystem::remove(pretty_path);
+    std::filesystem::remove(compact_path);
+    PASS();
+}
+
+// ============================================================================
+// Test 24: Async frame sink
+// ============================================================================
+void test_async_frame_sink() {
+    TEST("Async sink delivers in order with bounded backlog");
+
+    bh::SimulationConfig config = short_dp54_config();
+
+    bh::SimulationResult stored = bh::run_simulation(config);
+
+    // Everything arrives, in order, and finish() carries the summary through
+    {
+        bh::ColumnarFrameSink columns;
+        bh::AsyncFrameSink async(columns, 16, 2);
+        bh::run_simulation(config, async);
+        ASSERT_TRUE(columns.result.frames.size() == stored.frames.size(), "Frame count differs");
+        for (size_t i = 0; i < stored.frames.size(); i++) {
+            ASSERT_TRUE(columns.result.frames.time[i] == stored.frames[i].time &&
+                        columns.result.frames.h_plus[i] == stored.frames[i].gw.h_plus,
+                        "Frame differs or out of order");
+        }
+        ASSERT_TRUE(columns.result.merger_occurred, "Summary not delivered");
+        ASSERT_CLOSE(columns.result.qnm.frequency, stored.qnm.frequency, 0.0, "QNM differs");
+    }
+
+    // A slow destination makes push() wait instead of queueing without bound
+    const size_t batch = 8, max_batches = 3;
+    std::atomic<size_t> delivered(0);
+    bh::CallbackFrameSink slow([&](const bh::SimulationFrame&) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        delivered++;
+    });
+    size_t pushed = 0, worst_backlog = 0;
+    size_t stalls;
+    {
+        bh::AsyncFrameSink async(slow, batch, max_batches);
+        bh::CallbackFrameSink producer([&](const bh::SimulationFrame& f) {
+            async.push(f);
+            pushed++;
+            worst_backlog = std::max(worst_backlog, pushed - delivered.load());
+        });
+        for (int k = 0; k < 400; k++) producer.push(stored.frames[k % stored.frames.size()]);
+        stalls = async.stalls();
+    }   // Destructor drains the queue
+
+    ASSERT_TRUE(stalls > 0, "Producer never waited for the writer");
+    ASSERT_TRUE(worst_backlog <= (max_batches + 2) * batch, "Backlog exceeded the bound");
+    ASSERT_TRUE(delivered == pushed, "Destructor did not deliver queued frames");
+    PASS();
+}
+
+// ============================================================================
+// Test 25: Timeline cursor and time index
+// ============================================================================
+static bool same_render_data(const bh::CollisionRenderData& a, const bh::CollisionRenderData& b) {
+    return a.time == b.time && a.phase == b.phase && a.num_black_holes == b.num_black_holes &&
+           a.black_holes[0].position == b.black_holes[0].position &&
+           a.black_holes[1].position == b.black_holes[1].position &&
+           a.gw_strain_plus == b.gw_strain_plus && a.orbital_phase == b.orbital_phase;
+}
+
+void test_timeline_cursor() {
+    TEST("Timeline cursor and time index match the search");
+
+    bh::SimulationConfig config = short_dp54_config();
+
+    bh::SimulationResult result = bh::run_simulation(config);
+    bh::CollisionTimeline plain = bh::CollisionTimeline::build(result);
+    bh::CollisionTimeline indexed = plain;
+    indexed.build_time_index();
+    bh::CollisionTimeline coarse = plain;
+    coarse.build_time_index(7);    // Buckets spanning many plunge frames
+    ASSERT_TRUE(indexed.time_index.size() == plain.frames.size(), "Index size wrong");
+
+    // Forward playback, then backwards, then jumps across the whole run
+    std::vector<float> times;
+    float T = plain.total_duration;
+    for (int k = -3; k <= 3000; k++) times.push_back(T * (float)k / 3000.0f);
+    for (int k = 3000; k >= 0; k -= 3) times.push_back(T * (float)k / 3000.0f);
+    for (int k = 0; k < 500; k++) times.push_back(T * (float)((k * 7919) % 1000) / 1000.0f);
+    times.push_back(plain.merger_time);
+    times.push_back(T + 10.0f);
+
+    bh::TimelineCursor<bh::CollisionTimeline> cursor(plain);
+    bh::TimelineCursor<bh::CollisionTimeline> indexed_cursor(indexed);
+    for (float t : times) {
+        float tc = std::max(0.0f, std::min(t, T));
+        bh::CollisionRenderData expected = plain.interpolate(t);
+        ASSERT_TRUE(indexed.find_frame(tc) == plain.find_frame(tc) &&
+                    coarse.find_frame(tc) == plain.find_frame(tc), "Indexed lookup differs");
+        ASSERT_TRUE(same_render_data(cursor.interpolate(t), expected), "Cursor result differs");
+        ASSERT_TRUE(cursor.index() == plain.find_frame(tc), "Cursor bracket differs");
+        ASSERT_TRUE(same_render_data(indexed_cursor.interpolate(t), expected),
+                    "Indexed cursor result differs");
+    }
+
+    // Exactly on frame times, including the merger frame and the first
+    // ringdown frame, which share a time
+    for (size_t i = 0; i < plain.frames.size(); i++) {
+        float t = plain.frames[i].time;
+        ASSERT_TRUE(same_render_data(cursor.interpolate(t), plain.interpolate(t)),
+                    "Cursor differs on a frame time");
+        ASSERT_TRUE(indexed.find_frame(t) == plain.find_frame(t), "Index differs on a frame time");
+    }
+
+    // A single frame neither hangs nor reads past the end
+    bh::CollisionTimeline one = plain;
+    one.frames.resize(1);
+    one.total_duration = one.frames[0].time;
+    one.build_time_index();
+    bh::TimelineCursor<bh::CollisionTimeline> one_cursor(one);
+    ASSERT_TRUE(same_render_data(one.interpolate(5.0f), one.frames[0]) &&
+                same_render_data(one_cursor.interpolate(5.0f), one.frames[0]),
+                "Single-frame timeline wrong");
+    PASS();
+}
+
+// ============================================================================
+// Test 26: Hermite interpolation and thinned timelines
+// ============================================================================
+void test_hermite_timeline() {
+    TEST("Hermite playback and thinned timeline build");
+
+    // A circular orbit sampled every 0.2 rad: linear blending cuts the
+    // chord by r (1 - cos 0.1) = 0.025 M, the Hermite cubic follows the arc
+    const double r = 5.0, omega = 0.05, dt = 4.0;
+    bh::SimulationResult circle = {};
+    for (int i = 0; i <= 100; i++) {
+        double t = i * dt, phi = omega * t;
+        bh::SimulationFrame f = {};
+        f.time = t;
+        f.bh1.mass = f.bh2.mass = 0.5;
+        f.bh1.position = glm::dvec3(r * std::cos(phi), 0.0, r * std::sin(phi));
+        f.bh1.velocity = glm::dvec3(-r * omega * std::sin(phi), 0.0, r * omega * std::cos(phi));
+        f.bh2.position = -f.bh1.position;
+        f.bh2.velocity = -f.bh1.velocity;
+        circle.frames.push_back(f);
+    }
+    bh::CollisionTimeline orbit = bh::CollisionTimeline::build(circle);
+
+    double max_error = 0, max_speed_error = 0;
+    for (int k = 0; k < 400; k++) {
+        double t = 0.995 * k;
+        bh::CollisionRenderData rd = orbit.interpolate((float)t);
+        glm::dvec3 expected(r * std::cos(omega * t), 0.0, r * std::sin(omega * t));
+        max_error = std::max(max_error, glm::length(glm::dvec3(rd.black_holes[0].position) - expected));
+        max_speed_error = std::max(max_speed_error,
+            std::abs(glm::length(glm::dvec3(rd.black_holes[0].velocity)) - r * omega));
+    }
+    ASSERT_TRUE(max_error < 1e-4, "Hermite position off the orbit");
+    ASSERT_TRUE(max_speed_error < 1e-3, "Hermite velocity off the orbit");
+
+    // Thinning a real run keeps the merger and ringdown and every inspiral
+    // frame within the tolerance
+    bh::SimulationConfig config = short_dp54_config();
+    bh::SimulationResult result = bh::run_simulation(config);
+
+    const float tol = 1e-3f;
+    bh::CollisionTimeline full = bh::CollisionTimeline::build(result);
+    bh::CollisionTimeline thin = bh::CollisionTimeline::build(result, tol);
+    ASSERT_TRUE(thin.frames.size() * 100 < full.frames.size(), "Thinning kept too many frames");
+    ASSERT_TRUE(thin.frames.front().time == full.frames.front().time &&
+                thin.frames.back().time == full.frames.back().time, "Ends dropped");
+    ASSERT_TRUE(thin.merger_frame_index >= 0 &&
+                thin.frames[thin.merger_frame_index].time == full.frames[full.merger_frame_index].time,
+                "Merger frame dropped");
+    ASSERT_TRUE(thin.frames.size() - thin.merger_frame_index ==
+                full.frames.size() - full.merger_frame_index, "Merger or ringdown frames dropped");
+
+    double worst = 0;
+    for (const auto& f : result.frames) {
+        if (f.phase != 0) continue;
+        bh::CollisionRenderData rd = thin.interpolate((float)f.time);
+        worst = std::max(worst, glm::length(glm::dvec3(rd.black_holes[0].position) - f.bh1.position));
+        worst = std::max(worst, glm::length(glm::dvec3(rd.black_holes[1].position) - f.bh2.position));
+    }
+    // Float playback times add a little on top of the tolerance
+    ASSERT_TRUE(worst < 1.1 * tol, "Thinned timeline out of tolerance");
+    PASS();
+}
+
+// ============================================================================
+// Test 27: Error-bounded decimation
+// ============================================================================
+
+/// Largest excess over the tolerances when the frames of result are rebuilt
+/// from the decimated ones (0 if all fit)
+static double decimation_excess(const bh::SimulationResult& result,
+                                const std::vector<bh::SimulationFrame>& kept,
+                                const std::vector<uint64_t>& source,
+                                const bh::DecimationTolerances& tol) {
+    double excess = 0;
+    size_t k = 0;
+    for (size_t i = 0; i < result.frames.size(); i++) {
+        while (k + 1 < source.size() && source[k + 1] <= i) k++;
+        if (source[k] == i || k + 1 >= source.size()) continue;
+
+        const bh::SimulationFrame& a = kept[k];
+        const bh::SimulationFrame& b = kept[k + 1];
+        const bh::SimulationFrame& f = result.frames[i];
+        double dt = b.time - a.time, s = (f.time - a.time) / dt;
+        glm::dvec3 p1 = bh::detail::hermite_position(a.bh1.position, a.bh1.velocity,
+                                                     b.bh1.position, b.bh1.velocity, dt, s);
+        glm::dvec3 p2 = bh::detail::hermite_position(a.bh2.position, a.bh2.velocity,
+                                                     b.bh2.position, b.bh2.velocity, dt, s);
+        double hp = a.gw.h_plus + s * (b.gw.h_plus - a.gw.h_plus);
+        double hx = a.gw.h_cross + s * (b.gw.h_cross - a.gw.h_cross);
+
+        excess = std::max(excess, glm::length(p1 - f.bh1.position) - tol.position);
+        excess = std::max(excess, glm::length(p2 - f.bh2.position) - tol.position);
+        if (tol.h_plus > 0) excess = std::max(excess, std::abs(hp - f.gw.h_plus) - tol.h_plus);
+        if (tol.h_cross > 0) excess = std::max(excess, std::abs(hx - f.gw.h_cross) - tol.h_cross);
+    }
+    return excess;
+}
+
+void test_error_bounded_decimation() {
+    TEST("Error-bounded decimation within tolerance");
+
+    bh::SimulationConfig config = short_dp54_config();
+    bh::SimulationResult result = bh::run_simulation(config);
+    size_t n = result.frames.size();
+
+    bh::DecimationTolerances position_only;
+    position_only.h_plus = position_only.h_cross = 0;
+    bh::DecimationTolerances defaults;
+
+    struct Case { bh::DecimationTolerances tol; size_t max_span; };
+    const Case cases[] = { { defaults, 1 << 16 }, { position_only, 1 << 16 }, { defaults, 64 } };
+    size_t kept_count[3];
+
+    for (int c = 0; c < 3; c++) {
+        bh::VectorFrameSink out;
+        bh::ErrorBoundedFrameSink sink(out, cases[c].tol, cases[c].max_span);
+        for (const auto& f : result.frames) sink.push(f);
+        sink.finish(result);
+
+        const auto& source = sink.source_indices();
+        kept_count[c] = out.frames.size();
+        ASSERT_TRUE(source.size() == out.frames.size(), "Mapping size wrong");
+        ASSERT_TRUE(source.front() == 0 && source.back() == n - 1, "Ends dropped");
+        for (size_t k = 0; k < source.size(); k++) {
+            ASSERT_TRUE(k == 0 || source[k] > source[k - 1], "Mapping not increasing");
+            ASSERT_TRUE(out.frames[k].time == result.frames[source[k]].time, "Mapping points elsewhere");
+        }
+
+        size_t after_merger = 0;
+        for (const auto& f : out.frames) after_merger += f.phase != 0;
+        ASSERT_TRUE(after_merger == (size_t)config.ringdown_samples + 1, "Merger or ringdown dropped");
+
+        ASSERT_TRUE(decimation_excess(result, out.frames, source, cases[c].tol) <= 0,
+                    "Dropped frame not rebuilt within tolerance");
+    }
+
+    ASSERT_TRUE(kept_count[0] * 100 < n, "Decimation kept too many frames");
+    ASSERT_TRUE(kept_count[1] < kept_count[0], "Strain checks had no effect");
+    ASSERT_TRUE(kept_count[2] > kept_count[0], "Span limit had no effect");
+    PASS();
+}
+
+// ============================================================================
+// Test 28: Recording policies
+// ============================================================================
+void test_recording_policies() {
+    TEST("Recording policies place the inspiral frames");
+
+    bh::SimulationConfig config = short_dp54_config();
+    bh::SimulationResult classic = bh::run_simulation(config);
+
+    // The default is the classic cadence, spelled out
+    config.recording = std::make_shared<bh::PlungeRefinedRecording>(config.record_interval);
+    bh::SimulationResult explicit_classic = bh::run_simulation(config);
+    ASSERT_TRUE(explicit_classic.frames.size() == classic.frames.size(), "Default policy changed");
+    for (size_t i = 0; i < classic.frames.size(); i += 997) {
+        ASSERT_TRUE(explicit_classic.frames[i].time == classic.frames[i].time, "Default frame times changed");
+    }
+
+    std::shared_ptr<const bh::RecordingPolicy> policies[] = {
+        std::make_shared<bh::UniformTimeRecording>(2.0),
+        std::make_shared<bh::PerCycleRecording>(32),
+        std::make_shared<bh::GWFrequencyRecording>(1e-4),
+        std::make_shared<bh::PerCycleRecording>(1),
+    };
+    for (const auto& policy : policies) {
+        config.recording = policy;
+        bh::SimulationResult result = bh::run_simulation(config);
+
+        // Every inspiral frame sits where the policy asked after the one
+        // before; the recording does not touch the dynamics
+        ASSERT_TRUE(result.frames.size() < classic.frames.size() / 100, "Policy recorded too many frames");
+        ASSERT_TRUE(result.frames.front().time == 0.0, "First frame not at t = 0");
+        for (size_t i = 1; i < result.frames.size() && result.frames[i].phase == 0; i++) {
+            ASSERT_CLOSE(result.frames[i].time, policy->next_time(result.frames[i - 1]), 1e-9,
+                         "Frame not at the policy's time");
+        }
+        ASSERT_CLOSE(result.merger_time, classic.merger_time, 1e-12, "Recording changed the merger");
+        ASSERT_CLOSE(result.total_gw_cycles, classic.total_gw_cycles, 1e-9, "Recording changed the GW cycles");
+        ASSERT_TRUE(result.num_ringdown_frames == config.ringdown_samples, "Ringdown changed");
+    }
+
+    // The same holds on the RK4 path, down to one frame per orbit
+    {
+        bh::SimulationConfig rk4 = short_dp54_config();
+        rk4.binary.initial_separation = 8.0;
+        rk4.integrator.method = bh::IntegratorMethod::RK4;
+        bh::SimulationResult dense = bh::run_simulation(rk4);
+        rk4.recording = std::make_shared<bh::PerCycleRecording>(1);
+        bh::SimulationResult sparse = bh::run_simulation(rk4);
+        ASSERT_TRUE(dense.merger_occurred && dense.total_gw_cycles > 1.0, "RK4 run should merge");
+        ASSERT_CLOSE(sparse.total_gw_cycles, dense.total_gw_cycles, 1e-9, "RK4 GW cycles depend on recording");
+    }
+
+    // 32 frames per orbit: about 16 per GW cycle
+    config.recording = policies[1];
+    bh::SimulationResult per_cycle = bh::run_simulation(config);
+    double expected = 16.0 * per_cycle.total_gw_cycles;
+    ASSERT_CLOSE((double)per_cycle.num_inspiral_frames, expected, 0.05 * expected, "Frames per cycle wrong");
+
+    // A caller-defined policy asking for times that are not after the
+    // frame gets one frame per integrator step instead of looping forever
+    config.recording = std::make_shared<bh::CallbackRecording>(
+        [](const bh::SimulationFrame& f) { return f.time; });
+    config.binary.initial_separation = 6.0;
+    bh::SimulationResult every_step = bh::run_simulation(config);
+    ASSERT_TRUE(every_step.merger_occurred && every_step.num_inspiral_frames > 10, "Callback policy failed");
+    for (size_t i = 1; i < every_step.frames.size() && every_step.frames[i].phase == 0; i++) {
+        ASSERT_TRUE(every_step.frames[i].time > every_step.frames[i - 1].time, "Frame times not increasing");
+    }
+    PASS();
+}
+
+// ============================================================================
+// Test 29: Work counters
+// ============================================================================
+void test_simulation_stats() {
+    TEST("Work counters match evaluations per step");
+
+    bh::SimulationConfig config = short_dp54_config();
+    config.binary.initial_separation = 8.0;
+
+    // RK4: four evaluations per step, plus the one before the first step
+    config.integrator.method = bh::IntegratorMethod::RK4;
+    bh::SimulationResult rk4 = bh::run_simulation(config);
+    ASSERT_TRUE(rk4.stats.integrator_steps > 0, "No RK4 steps counted");
+    ASSERT_TRUE(rk4.stats.derivative_evaluations == 4 * rk4.stats.integrator_steps + 1,
+                "RK4 evaluations wrong");
+    ASSERT_TRUE(rk4.stats.rejected_steps == 0 && rk4.stats.secular_steps == 0, "RK4 counted rejections");
+
+    // DP54 (FSAL): six per attempt, accepted or rejected
+    config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    bh::SimulationResult dp = bh::run_simulation(config);
+    long long attempts = dp.stats.integrator_steps + dp.stats.rejected_steps;
+    ASSERT_TRUE(dp.stats.integrator_steps > 0, "No DP54 steps counted");
+    ASSERT_TRUE(dp.stats.derivative_evaluations == 6 * attempts + 1, "DP54 evaluations wrong");
+
+    // Frames: every one the sink saw, and make_frame() built all but the ringdown
+    ASSERT_TRUE(dp.stats.frames_recorded == (long long)dp.frames.size(), "Frame count wrong");
+    ASSERT_TRUE(dp.stats.make_frame_calls == dp.num_inspiral_frames, "make_frame calls wrong");
+
+#if BH_ENABLE_STATS
+    ASSERT_TRUE(dp.stats.min_dt > 0 && dp.stats.min_dt <= dp.stats.max_dt, "Step size range wrong");
+    ASSERT_TRUE(dp.stats.max_dt <= config.integrator.dt_max, "Step above dt_max");
+    double phases = dp.stats.inspiral_seconds + dp.stats.merger_seconds + dp.stats.ringdown_seconds;
+    ASSERT_TRUE(dp.stats.inspiral_seconds > 0 && dp.stats.make_frame_seconds > 0, "Timers not running");
+    ASSERT_TRUE(phases <= dp.stats.total_seconds, "Phase times exceed the total");
+#endif
+
+    // The fast-forward counts its own steps
+    config.binary.initial_separation = 14.0;
+    config.secular.enabled = true;
+    config.secular.handoff_separation = 10.0;
+    bh::SimulationResult ff = bh::run_simulation(config);
+    ASSERT_TRUE(ff.stats.secular_steps > 0 && ff.stats.integrator_steps > 0, "Fast-forward steps not counted");
+    PASS();
+}
+
+// ============================================================================
+// Test 30: Trace spans
+// ============================================================================
+void test_trace_spans() {
+    TEST("Trace spans per thread, only while tracing");
+
+    bh::SimulationConfig config = short_dp54_config();
+    config.binary.initial_separation = 8.0;
+
+    bh::trace_start();
+    bh::run_simulation(config);
+    std::thread worker([] { BH_TRACE_SCOPE("worker_span"); });
+    worker.join();
+    bh::trace_stop();
+    bh::run_simulation(config);   // Not traced
+
+    std::string path = (std::filesystem::temp_directory_path() / "bh_test_trace.json").string();
+    ASSERT_TRUE(bh::write_trace(path), "write_trace failed");
+    std::ifstream in(path);
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::filesystem::remove(path);
+
+    ASSERT_TRUE(text.rfind("{\"traceEvents\":[", 0) == 0, "Not a trace-event document");
+#if BH_ENABLE_TRACE
+    auto count = [&](const std::string& needle) {
+        size_t n = 0;
+        for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) n++;
+        return n;
+    };
+    ASSERT_TRUE(count("\"name\":\"run_simulation\"") == 1, "run_simulation span count wrong");
+    ASSERT_TRUE(count("\"name\":\"inspiral\"") == 1 && count("\"name\":\"merger\"") == 1 &&
+                count("\"name\":\"ringdown\"") == 1, "Phase spans missing");
+
+    // The worker's span is on a track of its own
+    size_t span = text.find("\"name\":\"worker_span\"");
+    size_t run = text.find("\"name\":\"run_simulation\"");
+    ASSERT_TRUE(span != std::string::npos, "Worker span missing");
+    auto tid_after = [&](size_t at) { return atoi(text.c_str() + text.find("\"tid\":", at) + 6); };
+    ASSERT_TRUE(tid_after(span) != tid_after(run), "Threads share a track");
+#endif
+    PASS();
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -346,6 +1695,26 @@ int main() {
     test_energy_loss_sign();
     test_merger_time_estimate();
     test_recoil_kick();
+    test_dopri5_error_control();
+    test_templated_stepper();
+    test_pn_kernel_specializations();
+    test_relative_state();
+    test_inspiral_batch();
+    test_secular_fast_forward();
+    test_dense_output();
+    test_frame_sinks();
+    test_columnar_result();
+    test_parameter_sweep();
+    test_run_file();
+    test_mapped_timeline();
+    test_json_writer();
+    test_async_frame_sink();
+    test_timeline_cursor();
+    test_hermite_timeline();
+    test_error_bounded_decimation();
+    test_recording_policies();
+    test_simulation_stats();
+    test_trace_spans();
 
     printf("\n================================================================\n");
     printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
@@ -0,0 +1,134 @@
+/**
+ * @file bench.h
+ * @brief Small self-contained microbenchmark harness for bh_collision_bench.
+ *
+ * A benchmark is a callable taking an iteration counter and returning a
+ * double derived from its result. The harness adds those up into a volatile,
+ * so the compiler cannot drop the work, and the counter lets a benchmark
+ * cycle through prepared inputs instead of timing one cached answer.
+ *
+ * Each run
+ *   1. doubles the batch size until one timed sample takes sample_ms,
+ *   2. runs untimed samples for warmup_ms,
+ *   3. times `repetitions` samples and reports the median and the 99th
+ *      percentile of the time per operation, and operations per second.
+ *
+ * An operation is one call unless the benchmark says a call does several
+ * (e.g. one export of n frames is n operations).
+ */
+
+#ifndef BH_COLLISION_BENCH_H
+#define BH_COLLISION_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace bh {
+namespace bench {
+
+struct Options {
+    std::string filter;        // Run only benchmarks whose name contains this
+    int repetitions = 50;      // Timed samples per benchmark
+    double sample_ms = 2.0;    // Target duration of one sample
+    double warmup_ms = 50.0;   // Untimed samples before measuring
+    bool csv = false;          // Print CSV instead of a table
+};
+
+struct Result {
+    std::string name;
+    double median_ns;          // Per operation
+    double p99_ns;             // Per operation
+    double ops_per_second;     // From the median
+    size_t batch;              // Calls per sample
+};
+
+class Runner {
+public:
+    explicit Runner(const Options& options) : options_(options) {}
+
+    /// Time fn, which does ops_per_call operations per call
+    template <typename Fn>
+    void run(const std::string& name, double ops_per_call, Fn&& fn)
+    {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string::npos) return;
+
+        // Calibrate: smallest power-of-two batch reaching sample_ms
+        size_t batch = 1;
+        size_t counter = 0;
+        while (sample(fn, batch, counter) < options_.sample_ms * 1e6 && batch < ((size_t)1 << 30)) {
+            batch *= 2;
+        }
+
+        // Warm up caches, branch predictors and the CPU clock
+        auto warmup_end = Clock::now() + std::chrono::duration<double, std::milli>(options_.warmup_ms);
+        while (Clock::now() < warmup_end) sample(fn, batch, counter);
+
+        std::vector<double> per_op(std::max(options_.repetitions, 1));
+        for (double& ns : per_op) {
+            ns = sample(fn, batch, counter) / ((double)batch * ops_per_call);
+        }
+        std::sort(per_op.begin(), per_op.end());
+
+        Result r;
+        r.name = name;
+        r.median_ns = per_op[per_op.size() / 2];
+        r.p99_ns = per_op[(size_t)std::ceil(0.99 * per_op.size()) - 1];
+        r.ops_per_second = 1e9 / r.median_ns;
+        r.batch = batch;
+        report(r);
+        results_.push_back(r);
+    }
+
+    const std::vector<Result>& results() const { return results_; }
+
+    /// Column headings (call once before the first run)
+    void print_header() const
+    {
+        if (options_.csv) {
+            printf("name,median_ns,p99_ns,ops_per_second,batch\n");
+        } else {
+            printf("  %-44s %12s %12s %14s\n", "benchmark", "median ns/op", "p99 ns/op", "ops/s");
+            printf("  %-44s %12s %12s %14s\n", "---------", "------------", "---------", "-----");
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Nanoseconds for batch calls
+    template <typename Fn>
+    double sample(Fn& fn, size_t batch, size_t& counter)
+    {
+        double sum = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < batch; i++) sum += fn(counter++);
+        auto end = Clock::now();
+        sink_ = sink_ + sum;
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+    void report(const Result& r) const
+    {
+        if (options_.csv) {
+            printf("%s,%.3f,%.3f,%.1f,%zu\n", r.name.c_str(), r.median_ns, r.p99_ns,
+                   r.ops_per_second, r.batch);
+        } else {
+            printf("  %-44s %12.2f %12.2f %14.4g\n", r.name.c_str(), r.median_ns, r.p99_ns,
+                   r.ops_per_second);
+        }
+        fflush(stdout);
+    }
+
+    Options options_;
+    std::vector<Result> results_;
+    volatile double sink_ = 0;
+};
+
+} // namespace bench
+} // namespace bh
+
+#endif // BH_COLLISION_BENCH_H
@@ -0,0 +1,270 @@
+/**
+ * @file bench_main.cpp
+ * @brief bh_collision_bench: per-function timings of the hot kernels.
+ *
+ * Usage:
+ *   bh_collision_bench [--filter <text>] [--reps <n>] [--sample-ms <ms>] [--csv]
+ *
+ * Kernels read their inputs from a ring of states spread over an inspiral
+ * (separations 6-20 M, all orbital phases), so every call does real work
+ * with realistic branches. Timeline and export benchmarks use the frames of
+ * a short simulated run.
+ */
+
+#include "bench.h"
+
+#include "bh_collision/simulation.h"
+#include "bh_collision/physics.h"
+#include "bh_collision/pn_kernel.h"
+#include "bh_collision/integrator.h"
+#include "bh_collision/merger.h"
+#include "bh_collision/integration_api.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t NUM_INPUTS = 1024;   // Power of two: inputs are picked by i & (NUM_INPUTS - 1)
+
+struct Inputs {
+    std::vector<bh::BlackHole> bh1, bh2;
+    std::vector<bh::BinaryState> binary;
+    std::vector<bh::RelativeState> relative;
+    std::vector<double> ringdown_times;
+};
+
+/// Equal-mass bodies on circular orbits from 20 M in to 6 M
+Inputs make_inputs()
+{
+    Inputs in;
+    bh::BinaryConfig config;
+    bh::BlackHole proto1, proto2;
+    bh::init_binary(config, proto1, proto2);
+
+    for (size_t k = 0; k < NUM_INPUTS; k++) {
+        double r = 20.0 - 14.0 * (double)k / (NUM_INPUTS - 1);
+        double phi = 0.37 * (double)k;
+        double v = std::sqrt(1.0 / r);
+        glm::dvec3 rel_pos(r * std::cos(phi), 0.0, r * std::sin(phi));
+        glm::dvec3 rel_vel(-v * std::sin(phi), 0.0, v * std::cos(phi));
+
+        bh::BlackHole a = proto1, b = proto2;
+        a.position = config.m2 * rel_pos;
+        a.velocity = config.m2 * rel_vel;
+        b.position = -config.m1 * rel_pos;
+        b.velocity = -config.m1 * rel_vel;
+        in.bh1.push_back(a);
+        in.bh2.push_back(b);
+
+        bh::BinaryState s;
+        s.pos1 = a.position;
+        s.vel1 = a.velocity;
+        s.pos2 = b.position;
+        s.vel2 = b.velocity;
+        s.time = 0.0;
+        in.binary.push_back(s);
+
+        bh::RelativeState rs;
+        rs.r = rel_pos;
+        rs.v = rel_vel;
+        rs.time = 0.0;
+        in.relative.push_back(rs);
+
+        in.ringdown_times.push_back(100.0 * (double)k / NUM_INPUTS);
+    }
+    return in;
+}
+
+double sum(const glm::dvec3& v) { return v.x + v.y + v.z; }
+double sum(const glm::vec3& v) { return (double)(v.x + v.y + v.z); }
+
+void bench_pn_orders(bh::bench::Runner& runner, const Inputs& in)
+{
+    struct Order { const char* name; bool pn1, pn2, pn25; };
+    const Order orders[] = {
+        { "newtonian", false, false, false },
+        { "1pn", true, false, false },
+        { "2pn", true, true, false },
+        { "2.5pn", true, true, true },
+    };
+
+    for (const Order& o : orders) {
+        runner.run(std::string("compute_relative_acceleration/") + o.name, 1, [&](size_t i) {
+            const bh::RelativeState& s = in.relative[i & (NUM_INPUTS - 1)];
+            return sum(bh::compute_relative_acceleration(s.r, s.v, 0.5, 0.5, o.pn1, o.pn2, o.pn25).total());
+        });
+    }
+
+    // The specialised kernel the integrator inlines (pn_kernel.h)
+    bh::PNCoefficients coeffs = bh::make_pn_coefficients(0.5, 0.5);
+    runner.run("pn_relative_acceleration/2.5pn", 1, [&](size_t i) {
+        const bh::RelativeState& s = in.relative[i & (NUM_INPUTS - 1)];
+        return sum(bh::pn_relative_acceleration<true, true, true>(s.r, s.v, coeffs));
+    });
+}
+
+void bench_steppers(bh::bench::Runner& runner, const Inputs& in)
+{
+    const double dt = 0.05;
+
+    // The public BinaryState stepper, through std::function
+    bh::DerivativeFunc binary_deriv = [](const bh::BinaryState& s) {
+        bh::BinaryStateDerivative d;
+        glm::dvec3 a = bh::compute_relative_acceleration(
+            s.pos1 - s.pos2, s.vel1 - s.vel2, 0.5, 0.5).total();
+        d.dpos1 = s.vel1;
+        d.dvel1 = 0.5 * a;
+        d.dpos2 = s.vel2;
+        d.dvel2 = -0.5 * a;
+        return d;
+    };
+    runner.run("rk4_step/binary_std_function", 1, [&](size_t i) {
+        bh::BinaryState next = bh::rk4_step(in.binary[i & (NUM_INPUTS - 1)], dt, binary_deriv);
+        return sum(next.pos1);
+    });
+
+    // The templated stepper on the relative orbit, as run_simulation uses it
+    bh::PNCoefficients coeffs = bh::make_pn_coefficients(0.5, 0.5);
+    auto relative_deriv = [&](const bh::RelativeState& s) {
+        return bh::RelativeStateDerivative{
+            s.v, bh::pn_relative_acceleration<true, true, true>(s.r, s.v, coeffs) };
+    };
+    runner.run("rk4_step/relative_inlined", 1, [&](size_t i) {
+        bh::RelativeState next = bh::rk4_step(in.relative[i & (NUM_INPUTS - 1)], dt, relative_deriv);
+        return sum(next.r);
+    });
+}
+
+void bench_observables(bh::bench::Runner& runner, const Inputs& in)
+{
+    runner.run("compute_orbital_params", 1, [&](size_t i) {
+        size_t k = i & (NUM_INPUTS - 1);
+        bh::OrbitalParams p = bh::compute_orbital_params(in.bh1[k], in.bh2[k]);
+        return p.separation + p.orbital_phase + p.energy;
+    });
+
+    runner.run("compute_gw_strain", 1, [&](size_t i) {
+        size_t k = i & (NUM_INPUTS - 1);
+        bh::GWStrain h = bh::compute_gw_strain(in.bh1[k], in.bh2[k], 1e6, 0.3);
+        return h.h_plus + h.h_cross;
+    });
+
+    bh::QNMParams qnm = bh::compute_qnm_222(0.95, 0.69, 0.4);
+    runner.run("ringdown_strain", 1, [&](size_t i) {
+        bh::GWStrain h = bh::ringdown_strain(qnm, in.ringdown_times[i & (NUM_INPUTS - 1)], 1e6, 0.3);
+        return h.h_plus + h.h_cross;
+    });
+}
+
+/// A short run with a few thousand frames for the timeline and export
+bh::SimulationResult small_run()
+{
+    bh::SimulationConfig config;
+    config.binary.initial_separation = 10.0;
+    config.record_interval = 1.0;
+    config.ringdown_samples = 200;
+    config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    config.integrator.relative_coordinates = true;
+    config.recording = std::make_shared<bh::UniformTimeRecording>(0.25);
+    return bh::run_simulation(config);
+}
+
+void bench_timeline(bh::bench::Runner& runner, const bh::SimulationResult& result)
+{
+    bh::CollisionTimeline timeline = bh::CollisionTimeline::build(result);
+    float duration = timeline.total_duration;
+
+    // Scattered times: a fixed pseudo-random permutation of the duration
+    std::vector<float> times(NUM_INPUTS);
+    for (size_t k = 0; k < NUM_INPUTS; k++) {
+        times[k] = duration * (float)((k * 7919) % NUM_INPUTS) / (float)NUM_INPUTS;
+    }
+    runner.run("CollisionTimeline::interpolate/random", 1, [&](size_t i) {
+        return sum(timeline.interpolate(times[i & (NUM_INPUTS - 1)]).black_holes[0].position);
+    });
+
+    // Playback: small steps forward through the whole run, through a cursor
+    bh::TimelineCursor<bh::CollisionTimeline> cursor(timeline);
+    const size_t playback_steps = 1 << 16;
+    runner.run("CollisionTimeline::interpolate/playback_cursor", 1, [&](size_t i) {
+        float t = duration * (float)(i % playback_steps) / (float)playback_steps;
+        return sum(cursor.interpolate(t).black_holes[0].position);
+    });
+}
+
+void bench_export(bh::bench::Runner& runner, const bh::SimulationResult& result)
+{
+    std::string path = (std::filesystem::temp_directory_path() / "bh_collision_bench.json").string();
+    double frames = (double)result.frames.size();
+
+    bh::ExportOptions pretty, compact;
+    compact.compact = true;
+    runner.run("export_to_json/per_frame", frames, [&](size_t) {
+        return bh::export_to_json(result, path, pretty) ? 1.0 : 0.0;
+    });
+    runner.run("export_to_json/per_frame_compact", frames, [&](size_t) {
+        return bh::export_to_json(result, path, compact) ? 1.0 : 0.0;
+    });
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+void print_help()
+{
+    printf(
+        "Usage: bh_collision_bench [options]\n\n"
+        "Options:\n"
+        "  --filter <text>     Run only benchmarks whose name contains text\n"
+        "  --reps <n>          Timed samples per benchmark (default 50)\n"
+        "  --sample-ms <ms>    Target length of one sample (default 2)\n"
+        "  --csv               Print CSV instead of a table\n"
+        "  --help              Show this help\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bh::bench::Options options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_help();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            options.repetitions = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--sample-ms") == 0 && i + 1 < argc) {
+            options.sample_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--csv") == 0) {
+            options.csv = true;
+        }
+        else {
+            printf("Unknown option: %s\n", argv[i]);
+            print_help();
+            return 1;
+        }
+    }
+
+    Inputs inputs = make_inputs();
+    bh::SimulationResult result = small_run();
+
+    bh::bench::Runner runner(options);
+    runner.print_header();
+    bench_pn_orders(runner, inputs);
+    bench_steppers(runner, inputs);
+    bench_observables(runner, inputs);
+    bench_timeline(runner, result);
+    bench_export(runner, result);
+    return 0;
+}
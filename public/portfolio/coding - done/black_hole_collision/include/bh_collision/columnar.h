@@ -0,0 +1,110 @@
+/**
+ * @file columnar.h
+ * @brief Structure-of-arrays storage for simulation frames.
+ *
+ * A SimulationFrame is about 300 bytes, and an analysis that reads one or two
+ * quantities per frame (the strain, the separation) pulls a whole cache line
+ * for each 8-byte value it uses. FrameColumns keeps every field of
+ * SimulationFrame in its own contiguous array, vector quantities split into
+ * x/y/z, so a scan over one quantity is a unit-stride loop the compiler can
+ * vectorize. Convert from and to the frame-per-record form with
+ * to_columnar() / to_result(), or record straight into columns with
+ * ColumnarFrameSink.
+ */
+
+#ifndef BH_COLLISION_COLUMNAR_H
+#define BH_COLLISION_COLUMNAR_H
+
+#include "simulation.h"
+#include "frame_sink.h"
+#include <vector>
+
+namespace bh {
+
+/// x, y and z components of a vector quantity, one array each
+struct Vec3Columns {
+    std::vector<double> x, y, z;
+};
+
+/// BlackHole fields, one array each
+struct BodyColumns {
+    std::vector<double> mass;
+    std::vector<double> chi;
+    Vec3Columns position;
+    Vec3Columns velocity;
+    Vec3Columns spin_axis;
+};
+
+/// Every field of SimulationFrame, one array each. All arrays have size().
+struct FrameColumns {
+    std::vector<double> time;
+    std::vector<int> phase;         // 0=inspiral, 1=merger, 2=ringdown, 3=post-ringdown
+
+    BodyColumns bh1, bh2;
+
+    // OrbitalParams
+    std::vector<double> separation;
+    std::vector<double> orbital_frequency;
+    std::vector<double> orbital_phase;
+    std::vector<double> radial_velocity;
+    std::vector<double> velocity_param;
+    std::vector<double> reduced_mass;
+    std::vector<double> total_mass;
+    std::vector<double> symmetric_mass_ratio;
+    std::vector<double> chirp_mass;
+    std::vector<double> energy;
+    std::vector<double> angular_momentum;
+
+    // GWStrain
+    std::vector<double> h_plus;
+    std::vector<double> h_cross;
+    std::vector<double> gw_amplitude;
+    std::vector<double> gw_frequency;
+
+    size_t size() const { return time.size(); }
+    bool empty() const { return time.empty(); }
+
+    void reserve(size_t n);
+    void clear();
+    void push_back(const SimulationFrame& frame);
+
+    /// Reassemble frame i
+    SimulationFrame frame(size_t i) const;
+};
+
+/// SimulationResult with its frames stored as columns
+struct ColumnarResult {
+    FrameColumns frames;
+    BinaryConfig config;
+    RemnantProperties remnant;
+    QNMParams qnm;
+    double merger_time;
+    double total_gw_cycles;
+    double total_energy_radiated;
+    bool merger_occurred;
+    int num_inspiral_frames;
+    int num_ringdown_frames;
+    SimulationStats stats;   // Not stored in .bhrun files; read_run() leaves it zero
+};
+
+/// Copy a result into columnar form
+ColumnarResult to_columnar(const SimulationResult& result);
+
+/// Copy a columnar result back into one SimulationFrame per record
+SimulationResult to_result(const ColumnarResult& columnar);
+
+/// Records frames straight into columns:
+///   ColumnarFrameSink sink;
+///   run_simulation(config, sink);
+///   use(sink.result);
+class ColumnarFrameSink : public FrameSink {
+public:
+    ColumnarResult result = {};
+
+    void push(const SimulationFrame& frame) override { result.frames.push_back(frame); }
+    void finish(const SimulationResult& summary) override;
+};
+
+} // namespace bh
+
+#endif // BH_COLLISION_COLUMNAR_H
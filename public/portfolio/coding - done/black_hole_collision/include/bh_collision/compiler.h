@@ -0,0 +1,20 @@
+/**
+ * @file compiler.h
+ * @brief Portable compiler hints used on the integrator hot path.
+ */
+
+#ifndef BH_COLLISION_COMPILER_H
+#define BH_COLLISION_COMPILER_H
+
+#if defined(_MSC_VER)
+#define BH_FORCEINLINE __forceinline
+#define BH_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__) || defined(__clang__)
+#define BH_FORCEINLINE inline __attribute__((always_inline))
+#define BH_NOINLINE __attribute__((noinline))
+#else
+#define BH_FORCEINLINE inline
+#define BH_NOINLINE
+#endif
+
+#endif // BH_COLLISION_COMPILER_H
@@ -0,0 +1,221 @@
+/**
+ * @file frame_sink.h
+ * @brief Streaming destinations for the frames recorded by run_simulation().
+ *
+ * run_simulation(config) keeps every frame in SimulationResult::frames, which
+ * grows for the whole run; with the fine plunge sampling that is hundreds of
+ * megabytes. The FrameSink overload of run_simulation() instead hands each
+ * frame to the sink as soon as it is recorded and keeps nothing itself, so
+ * a long run written straight to disk uses constant memory and a consumer
+ * can start on the early inspiral while the plunge is still integrating.
+ *
+ * Sinks chain: a DecimatingFrameSink or ErrorBoundedFrameSink thins the
+ * stream before passing it on to any other sink, a TeeFrameSink feeds two,
+ * and an AsyncFrameSink moves the sink after it onto a background thread.
+ */
+
+#ifndef BH_COLLISION_FRAME_SINK_H
+#define BH_COLLISION_FRAME_SINK_H
+
+#include "simulation.h"
+#include "json_writer.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bh {
+
+/// Receives frames from run_simulation() in time order
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+
+    /// Called once per recorded frame, while the simulation is running
+    virtual void push(const SimulationFrame& frame) = 0;
+
+    /// Called once after the last frame with the run summary (remnant, QNM,
+    /// merger time, GW cycles). summary.frames is empty.
+    virtual void finish(const SimulationResult& /*summary*/) {}
+};
+
+/// Keeps every frame in memory (what run_simulation(config) uses)
+class VectorFrameSink : public FrameSink {
+public:
+    std::vector<SimulationFrame> frames;
+
+    void push(const SimulationFrame& frame) override { frames.push_back(frame); }
+};
+
+/// Forwards every frame to a caller-supplied function
+class CallbackFrameSink : public FrameSink {
+public:
+    using Callback = std::function<void(const SimulationFrame&)>;
+
+    explicit CallbackFrameSink(Callback callback) : callback_(std::move(callback)) {}
+
+    void push(const SimulationFrame& frame) override { callback_(frame); }
+
+private:
+    Callback callback_;
+};
+
+/// Writes frames to a JSON file as they arrive. The document has the same
+/// members as export_to_json(), with "frames" first because the metadata,
+/// config and remnant are only known once the run finishes.
+class JsonFrameSink : public FrameSink {
+public:
+    explicit JsonFrameSink(const std::string& filename, const ExportOptions& options = {});
+
+    /// False if the file could not be created; frames are then dropped
+    bool is_open() const { return out_.is_open(); }
+
+    /// True once finish() has written the summary and closed the file
+    /// without error
+    bool complete() const { return complete_; }
+
+    void push(const SimulationFrame& frame) override;
+    void finish(const SimulationResult& summary) override;
+
+private:
+    std::ofstream out_;
+    JsonWriter json_;
+    size_t num_frames_ = 0;
+    bool complete_ = false;
+};
+
+/// Passes on every keep_every-th inspiral frame, starting with the first,
+/// and every merger and ringdown frame
+class DecimatingFrameSink : public FrameSink {
+public:
+    DecimatingFrameSink(FrameSink& next, int keep_every)
+        : next_(next), keep_every_(keep_every < 1 ? 1 : keep_every) {}
+
+    void push(const SimulationFrame& frame) override;
+    void finish(const SimulationResult& summary) override { next_.finish(summary); }
+
+private:
+    FrameSink& next_;
+    int keep_every_;
+    long long inspiral_seen_ = 0;
+};
+
+/// How far interpolation between the frames an ErrorBoundedFrameSink keeps
+/// may stray from a frame it drops, per channel. Positions are checked
+/// against the cubic Hermite through the neighbours' positions and
+/// velocities (what CollisionTimeline plays back), the strain against a
+/// straight line. A channel with a tolerance of 0 or less is not checked.
+struct DecimationTolerances {
+    double position = 1e-3;   // Either black hole, in M
+    double h_plus = 1e-9;     // About 0.1% of the peak strain at the
+    double h_cross = 1e-9;    // default observer distance of 1e6 M
+};
+
+/// Passes on only the inspiral frames that interpolation cannot rebuild
+/// within the tolerances: line simplification with one bound per channel.
+/// Merger and ringdown frames always pass.
+///
+/// Frames are held back until the next kept frame is known. The span from
+/// the last kept frame doubles until some frame inside it misses, then a
+/// bisection over the held frames finds the furthest end that fits, so each
+/// frame is checked O(log span) times. At most max_span frames are held;
+/// finish() passes on what is left.
+class ErrorBoundedFrameSink : public FrameSink {
+public:
+    ErrorBoundedFrameSink(FrameSink& next, const DecimationTolerances& tolerances,
+                          size_t max_span = 1 << 16)
+        : next_(next), tolerances_(tolerances), max_span_(max_span < 2 ? 2 : max_span) {}
+
+    void push(const SimulationFrame& frame) override;
+    void finish(const SimulationResult& summary) override;
+
+    /// Frame index mapping: entry k is the position in the incoming stream
+    /// of the k-th frame passed on
+    const std::vector<uint64_t>& source_indices() const { return source_indices_; }
+
+private:
+    bool fits(size_t end) const;
+    void keep(size_t i);
+    void resolve(size_t bad);
+    void drain();
+
+    FrameSink& next_;
+    DecimationTolerances tolerances_;
+    size_t max_span_;
+    std::vector<SimulationFrame> window_;   // Last kept frame, then the held ones
+    uint64_t window_start_ = 0;             // Incoming index of window_[0]
+    uint64_t seen_ = 0;
+    size_t good_ = 0;                       // Furthest end known to fit
+    std::vector<uint64_t> source_indices_;
+};
+
+/// Passes every frame and the summary to two sinks, first a then b
+class TeeFrameSink : public FrameSink {
+public:
+    TeeFrameSink(FrameSink& a, FrameSink& b) : a_(a), b_(b) {}
+
+    void push(const SimulationFrame& frame) override { a_.push(frame); b_.push(frame); }
+    void finish(const SimulationResult& summary) override { a_.finish(summary); b_.finish(summary); }
+
+private:
+    FrameSink& a_;
+    FrameSink& b_;
+};
+
+/// Hands frames to another sink on a background thread, so a slow
+/// destination such as a file does not hold up the integrator. Frames
+/// travel in batches of batch_frames through a queue of at most max_batches;
+/// when the writer falls that far behind, push() waits for it
+/// (backpressure), which bounds memory to about (max_batches + 2) batches.
+///
+/// finish() flushes the last partial batch, waits until the writer has
+/// delivered every frame, then calls next.finish() with the summary, which
+/// is where file sinks write the remnant and QNM. next only ever runs on
+/// one thread at a time.
+class AsyncFrameSink : public FrameSink {
+public:
+    explicit AsyncFrameSink(FrameSink& next, size_t batch_frames = 1024, size_t max_batches = 8);
+
+    /// Delivers what is still queued (without next.finish()) if finish()
+    /// was not called
+    ~AsyncFrameSink() override;
+
+    AsyncFrameSink(const AsyncFrameSink&) = delete;
+    AsyncFrameSink& operator=(const AsyncFrameSink&) = delete;
+
+    void push(const SimulationFrame& frame) override;
+    void finish(const SimulationResult& summary) override;
+
+    /// Number of times push() had to wait for the writer
+    size_t stalls() const { return stalls_; }
+
+private:
+    void submit();
+    void stop();
+    void writer_loop();
+
+    FrameSink& next_;
+    size_t batch_frames_;
+    size_t max_batches_;
+    std::vector<SimulationFrame> current_;     // Filled by push()
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<std::vector<SimulationFrame>> queue_;
+    std::vector<std::vector<SimulationFrame>> spare_;   // Delivered batches, for reuse
+    bool closing_ = false;
+    size_t stalls_ = 0;
+
+    std::thread writer_;    // Last, so it starts after everything above
+};
+
+} // namespace bh
+
+#endif // BH_COLLISION_FRAME_SINK_H
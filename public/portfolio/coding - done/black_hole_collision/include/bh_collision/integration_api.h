@@ -11,6 +11,8 @@
 #define BH_COLLISION_INTEGRATION_API_H
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
 namespace bh {
@@ -24,6 +26,7 @@ struct BHRenderState {
     float spin;                 // Dimensionless spin [0,1)
     glm::vec3 spin_axis;        // Spin direction (unit vector)
     float isco_radius;          // Innermost stable circular orbit radius
+    glm::vec3 velocity;         // dx/dt, for Hermite interpolation of position
 };
 
 /// Complete render data for a single frame
@@ -37,6 +40,18 @@ struct CollisionRenderData {
     float gw_frequency;          // Instantaneous GW frequency
     float orbital_phase;         // Current orbital phase
     int phase;                   // 0=inspiral, 1=merger, 2=ringdown
+
+    /// Convert one simulation frame
+    static CollisionRenderData from_frame(const struct SimulationFrame& frame);
+
+    /// Blend frames a and b at time t; alpha in [0,1] is the weight of b.
+    /// Phase and black hole count switch over at alpha = 0.5. When both
+    /// frames hold the same black holes, positions follow the cubic Hermite
+    /// through their positions and velocities, which keeps orbits round
+    /// between sparse frames; everything else is mixed linearly.
+    static CollisionRenderData blend(const CollisionRenderData& a,
+                                     const CollisionRenderData& b,
+                                     float t, float alpha);
 };
 
 /// Timeline of render data for playback
@@ -46,13 +61,107 @@ struct CollisionTimeline {
     float merger_time;
     int merger_frame_index;
 
+    /// Optional lookup table (build_time_index()): entry b is find_frame()
+    /// of time b * time_index_step
+    std::vector<uint32_t> time_index;
+    float time_index_step = 0;
+
     /// Get interpolated render data at arbitrary time t
     CollisionRenderData interpolate(float t) const;
 
-    /// Build from simulation result (call after simulation completes)
-    static CollisionTimeline build(const struct SimulationResult& result);
+    /// Build from simulation result (call after simulation completes).
+    /// With max_position_error > 0 (in M), inspiral frames that Hermite
+    /// interpolation between the kept frames reproduces to within that
+    /// distance are left out (ErrorBoundedFrameSink, positions only); merger
+    /// and ringdown frames are always kept.
+    static CollisionTimeline build(const struct SimulationResult& result,
+                                   float max_position_error = 0);
+
+    /// Fill time_index with one entry per buckets equal time steps (default:
+    /// one per frame), making find_frame() O(1) on average instead of a
+    /// binary search
+    void build_time_index(size_t buckets = 0);
+
+    size_t size() const { return frames.size(); }
+    float frame_time(size_t i) const { return frames[i].time; }
+
+    /// Index lo of the frames bracketing t: the last frame before the final
+    /// one with time <= t, or 0
+    size_t find_frame(float t) const;
+
+    /// Interpolate at t between frames lo and lo + 1 (lo from find_frame())
+    CollisionRenderData interpolate_from(size_t lo, float t) const;
+};
+
+/// Playback position in a timeline (CollisionTimeline or
+/// CollisionTimelineView). Remembers the bracket of the last query and walks
+/// from it, so the small steps of playback, forwards or backwards, cost
+/// O(1) instead of a search; longer jumps fall back to find_frame(). Gives
+/// the same result as timeline.interpolate(t). The timeline must outlive
+/// the cursor.
+template <typename Timeline>
+class TimelineCursor {
+public:
+    explicit TimelineCursor(const Timeline& timeline) : timeline_(&timeline) {}
+
+    CollisionRenderData interpolate(float t)
+    {
+        if (timeline_->size() == 0) return CollisionRenderData{};
+
+        t = std::max(0.0f, std::min(t, timeline_->total_duration));
+        lo_ = seek(t);
+        return timeline_->interpolate_from(lo_, t);
+    }
+
+    /// Bracket of the last query
+    size_t index() const { return lo_; }
+
+private:
+    /// Steps tried before giving up on walking
+    static constexpr int MAX_WALK = 8;
+
+    size_t seek(float t) const
+    {
+        size_t n = timeline_->size();
+        size_t last = n < 2 ? 0 : n - 2;
+        size_t lo = std::min(lo_, last);
+
+        for (int step = 0; step < MAX_WALK; step++) {
+            if (lo > 0 && timeline_->frame_time(lo) > t) lo--;
+            else if (lo < last && timeline_->frame_time(lo + 1) <= t) lo++;
+            else return lo;
+        }
+        return timeline_->find_frame(t);
+    }
+
+    const Timeline* timeline_;
+    size_t lo_ = 0;
 };
 
+namespace detail {
+
+/// Position at s in [0,1] on the cubic Hermite through position p0 with
+/// velocity v0 at s = 0 and p1, v1 at s = 1, dt apart in time
+template <typename Vec, typename Real>
+inline Vec hermite_position(const Vec& p0, const Vec& v0, const Vec& p1, const Vec& v1,
+                            Real dt, Real s)
+{
+    Real s2 = s * s, s3 = s2 * s;
+    return (2 * s3 - 3 * s2 + 1) * p0 + (s3 - 2 * s2 + s) * dt * v0 +
+           (3 * s2 - 2 * s3) * p1 + (s3 - s2) * dt * v1;
+}
+
+/// Velocity (d/dt) on the same cubic
+template <typename Vec, typename Real>
+inline Vec hermite_velocity(const Vec& p0, const Vec& v0, const Vec& p1, const Vec& v1,
+                            Real dt, Real s)
+{
+    Real s2 = s * s;
+    return (6 * s2 - 6 * s) / dt * (p0 - p1) + (3 * s2 - 4 * s + 1) * v0 + (3 * s2 - 2 * s) * v1;
+}
+
+} // namespace detail
+
 } // namespace bh
 
 #endif // BH_COLLISION_INTEGRATION_API_H
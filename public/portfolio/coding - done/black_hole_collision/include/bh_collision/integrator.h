@@ -1,14 +1,17 @@
 /**
  * @file integrator.h
- * @brief RK4 numerical integrator with adaptive time stepping for
- *        binary black hole orbital dynamics.
+ * @brief RK4 and Dormand-Prince 5(4) numerical integrators with adaptive
+ *        time stepping for binary black hole orbital dynamics.
  */
 
 #ifndef BH_COLLISION_INTEGRATOR_H
 #define BH_COLLISION_INTEGRATOR_H
 
 #include "black_hole.h"
+#include "compiler.h"
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <vector>
 
@@ -27,6 +30,55 @@ struct BinaryStateDerivative {
     glm::dvec3 dpos2, dvel2;
 };
 
+BH_FORCEINLINE BinaryStateDerivative operator+(const BinaryStateDerivative& a,
+                                       const BinaryStateDerivative& b) {
+    return { a.dpos1 + b.dpos1, a.dvel1 + b.dvel1,
+             a.dpos2 + b.dpos2, a.dvel2 + b.dvel2 };
+}
+
+BH_FORCEINLINE BinaryStateDerivative operator*(double s, const BinaryStateDerivative& d) {
+    return { s * d.dpos1, s * d.dvel1, s * d.dpos2, s * d.dvel2 };
+}
+
+BH_FORCEINLINE BinaryStateDerivative operator-(const BinaryStateDerivative& a,
+                                               const BinaryStateDerivative& b) {
+    return { a.dpos1 - b.dpos1, a.dvel1 - b.dvel1, a.dpos2 - b.dpos2, a.dvel2 - b.dvel2 };
+}
+
+/// Reduced state: relative coordinate r = x1 - x2 and v = v1 - v2 in the
+/// center-of-mass frame. With the COM at rest at the origin the bodies are
+/// exactly x1 = (m2/M) r and x2 = -(m1/M) r, so half the components of
+/// BinaryState are redundant.
+struct RelativeState {
+    glm::dvec3 r, v;
+    double time = 0.0;
+};
+
+/// Derivative of the reduced state
+struct RelativeStateDerivative {
+    glm::dvec3 dr, dv;
+};
+
+BH_FORCEINLINE RelativeStateDerivative operator+(const RelativeStateDerivative& a,
+                                                 const RelativeStateDerivative& b) {
+    return { a.dr + b.dr, a.dv + b.dv };
+}
+
+BH_FORCEINLINE RelativeStateDerivative operator*(double s, const RelativeStateDerivative& d) {
+    return { s * d.dr, s * d.dv };
+}
+
+BH_FORCEINLINE RelativeStateDerivative operator-(const RelativeStateDerivative& a,
+                                                 const RelativeStateDerivative& b) {
+    return { a.dr - b.dr, a.dv - b.dv };
+}
+
+/// Time stepping scheme used for the inspiral
+enum class IntegratorMethod {
+    RK4,             // Classic RK4, step size from adaptive_timestep()
+    DormandPrince54  // Embedded 5(4) pair with local error control
+};
+
 /// Configuration for the integrator
 struct IntegratorConfig {
     double dt_initial = 0.1;        // Initial time step
@@ -34,11 +86,80 @@ struct IntegratorConfig {
     double dt_max = 1.0;            // Maximum allowed time step
     double safety_factor = 0.1;     // Fraction of orbital period for time step
     bool adaptive = true;           // Enable adaptive time stepping
+
+    IntegratorMethod method = IntegratorMethod::RK4;
+    double abs_tol = 1e-10;         // Absolute local error tolerance (DP54)
+    double rel_tol = 1e-10;         // Relative local error tolerance (DP54)
+
+    bool relative_coordinates = false; // Evolve RelativeState instead of BinaryState
 };
 
 /// Type alias for the derivative function
 using DerivativeFunc = std::function<BinaryStateDerivative(const BinaryState&)>;
 
+/// Outcome of one error-controlled step, after any rejected attempts
+template <typename State, typename StateDerivative>
+struct BasicAdaptiveStepResult {
+    State state;                     // Accepted state at time + dt_taken
+    StateDerivative deriv_end;       // Derivative at the accepted state (FSAL)
+    double dt_taken;                 // Step size actually used
+    double dt_next;                  // Suggested size for the next step
+    double error_norm;               // Scaled local error of the accepted step
+    int rejected;                    // Attempts rejected before acceptance
+    int evaluations;                 // Derivative evaluations spent
+};
+
+using AdaptiveStepResult = BasicAdaptiveStepResult<BinaryState, BinaryStateDerivative>;
+using RelativeStepResult = BasicAdaptiveStepResult<RelativeState, RelativeStateDerivative>;
+
+/// Continuous extension of one accepted step from y0 (at y0.time) to
+/// y0.time + h. With theta = (t - t0) / h the state is
+///   y(t) = y0 + theta (ydiff + (1-theta) (bspl + theta (c4 + (1-theta) c5)))
+/// (Hairer, Norsett & Wanner, "Solving ODEs I", II.6). With c5 = 0 this is
+/// the cubic Hermite interpolant through both ends and their derivatives;
+/// Dormand-Prince adds the 5th-order c5 term from its stages. The
+/// coefficients are stored as state increments in the derivative type.
+template <typename State, typename StateDerivative>
+struct BasicDenseOutput {
+    State y0;
+    double h;
+    StateDerivative ydiff;           // y1 - y0
+    StateDerivative bspl;            // h f0 - ydiff
+    StateDerivative c4;              // ydiff - h f1 - bspl
+    StateDerivative c5;              // 5th-order correction (zero for Hermite)
+};
+
+using DenseOutput = BasicDenseOutput<BinaryState, BinaryStateDerivative>;
+using RelativeDenseOutput = BasicDenseOutput<RelativeState, RelativeStateDerivative>;
+
+/// Helper: add a scalar multiple of derivative to a state
+BH_FORCEINLINE BinaryState state_add(const BinaryState& s, const BinaryStateDerivative& d, double dt) {
+    BinaryState result;
+    result.pos1 = s.pos1 + d.dpos1 * dt;
+    result.vel1 = s.vel1 + d.dvel1 * dt;
+    result.pos2 = s.pos2 + d.dpos2 * dt;
+    result.vel2 = s.vel2 + d.dvel2 * dt;
+    result.time = s.time + dt;
+    return result;
+}
+
+BH_FORCEINLINE RelativeState state_add(const RelativeState& s, const RelativeStateDerivative& d, double dt) {
+    RelativeState result;
+    result.r = s.r + d.dr * dt;
+    result.v = s.v + d.dv * dt;
+    result.time = s.time + dt;
+    return result;
+}
+
+/// Helper: the increment b - a, in the derivative type
+BH_FORCEINLINE BinaryStateDerivative state_diff(const BinaryState& b, const BinaryState& a) {
+    return { b.pos1 - a.pos1, b.vel1 - a.vel1, b.pos2 - a.pos2, b.vel2 - a.vel2 };
+}
+
+BH_FORCEINLINE RelativeStateDerivative state_diff(const RelativeState& b, const RelativeState& a) {
+    return { b.r - a.r, b.v - a.v };
+}
+
 /// Advance the binary state by one RK4 step
 /// Returns the new state after time step dt
 BinaryState rk4_step(
@@ -47,6 +168,20 @@ BinaryState rk4_step(
     const DerivativeFunc& deriv
 );
 
+/// Advance the binary state by one Dormand-Prince 5(4) step.
+/// k1 must be deriv(state); pass the previous deriv_end to reuse it (FSAL).
+/// The step is retried with a smaller dt until the scaled error estimate
+/// is <= 1, or dt reaches config.dt_min. If dense is given, it receives the
+/// 5th-order continuous extension of the accepted step.
+AdaptiveStepResult dopri5_step(
+    const BinaryState& state,
+    const BinaryStateDerivative& k1,
+    double dt,
+    const DerivativeFunc& deriv,
+    const IntegratorConfig& config,
+    DenseOutput* dense = nullptr
+);
+
 /// Compute an adaptive time step based on current orbital parameters
 double adaptive_timestep(
     const BinaryState& state,
@@ -54,8 +189,218 @@ double adaptive_timestep(
     double total_mass
 );
 
-/// Helper: add a scalar multiple of derivative to a state
-BinaryState state_add(const BinaryState& s, const BinaryStateDerivative& d, double dt);
+double adaptive_timestep(
+    const RelativeState& state,
+    const IntegratorConfig& config,
+    double total_mass
+);
+
+/// Step-size heuristic behind adaptive_timestep(): a fraction of the orbital
+/// period at this separation, shrunk further inside 2 r_ISCO. Inline so the
+/// batched engine (batch.h) can evaluate it across lanes.
+BH_FORCEINLINE double orbital_timestep(
+    double separation,
+    double safety_factor,
+    double dt_min, double dt_max,
+    double total_mass)
+{
+    // Orbital period estimate: T = 2π / ω = 2π sqrt(r³/M)
+    double orbital_period = 2.0 * M_PI * std::sqrt(
+        separation * separation * separation / total_mass
+    );
+
+    // Time step = safety_factor * orbital_period
+    // This ensures we take enough steps per orbit for accuracy
+    double dt = safety_factor * orbital_period;
+
+    // As BHs get very close, use even smaller steps
+    // Scale additionally by (r / r_isco) when close
+    double r_isco = 6.0 * total_mass;  // Schwarzschild ISCO for total mass
+    double scale = separation / (2.0 * r_isco);
+    dt = (separation < 2.0 * r_isco) ? dt * (scale * scale) : dt;
+
+    // Clamp to allowed range (min/max rather than std::clamp, which
+    // returns a reference and keeps the lane loop from vectorizing)
+    dt = std::min(std::max(dt, dt_min), dt_max);
+
+    return (separation < 1e-10) ? dt_min : dt;
+}
+
+// ============================================================================
+// Templated steppers
+//
+// These take the derivative callable by type, so a functor or lambda is
+// inlined into the stage loop instead of being called through std::function.
+// Overload resolution prefers the non-template versions above when an
+// actual DerivativeFunc is passed. Both BinaryState and RelativeState work;
+// the derivative type is whatever the callable returns.
+// ============================================================================
+
+namespace detail {
+
+// Dormand & Prince, J. Comp. Appl. Math. 6 (1980) 19; coefficients as in
+// Hairer, Norsett & Wanner, "Solving ODEs I", Table 5.2
+constexpr double dp_a21 = 1.0 / 5.0;
+constexpr double dp_a31 = 3.0 / 40.0,       dp_a32 = 9.0 / 40.0;
+constexpr double dp_a41 = 44.0 / 45.0,      dp_a42 = -56.0 / 15.0,     dp_a43 = 32.0 / 9.0;
+constexpr double dp_a51 = 19372.0 / 6561.0, dp_a52 = -25360.0 / 2187.0,
+                 dp_a53 = 64448.0 / 6561.0, dp_a54 = -212.0 / 729.0;
+constexpr double dp_a61 = 9017.0 / 3168.0,  dp_a62 = -355.0 / 33.0,    dp_a63 = 46732.0 / 5247.0,
+                 dp_a64 = 49.0 / 176.0,     dp_a65 = -5103.0 / 18656.0;
+constexpr double dp_a71 = 35.0 / 384.0,     dp_a73 = 500.0 / 1113.0,   dp_a74 = 125.0 / 192.0,
+                 dp_a75 = -2187.0 / 6784.0, dp_a76 = 11.0 / 84.0;
+
+// Error weights e = b5 - b4
+constexpr double dp_e1 = 71.0 / 57600.0,      dp_e3 = -71.0 / 16695.0,  dp_e4 = 71.0 / 1920.0,
+                 dp_e5 = -17253.0 / 339200.0, dp_e6 = 22.0 / 525.0,     dp_e7 = -1.0 / 40.0;
+
+// Dense output: 5th-order correction weights (Hairer's CONTD5 in DOPRI5)
+constexpr double dp_d1 = -12715105075.0 / 11282082432.0,  dp_d3 = 87487479700.0 / 32700410799.0,
+                 dp_d4 = -10690763975.0 / 1880347072.0,   dp_d5 = 701980252875.0 / 199316789632.0,
+                 dp_d6 = -1453857185.0 / 822651844.0,     dp_d7 = 69997945.0 / 29380423.0;
+
+// Step size controller
+constexpr double dp_safety = 0.9;
+constexpr double dp_min_scale = 0.2;
+constexpr double dp_max_scale = 5.0;
+
+/// RMS of err_i / (atol + rtol * max(|y0_i|, |y1_i|)) over all components
+double scaled_error(const BinaryState& y0, const BinaryState& y1,
+                    const BinaryStateDerivative& err,
+                    double atol, double rtol);
+
+double scaled_error(const RelativeState& y0, const RelativeState& y1,
+                    const RelativeStateDerivative& err,
+                    double atol, double rtol);
+
+} // namespace detail
+
+/// RK4 with k1 = deriv(state) supplied by the caller, e.g. the derivative
+/// at the end of the previous step that was also used for dense output
+template <typename State, typename StateDerivative, typename Deriv>
+State rk4_step(
+    const State& state,
+    const StateDerivative& k1,
+    double dt,
+    const Deriv& deriv)
+{
+    // Classic 4th-order Runge-Kutta
+    StateDerivative k2 = deriv(state_add(state, k1, dt * 0.5));
+    StateDerivative k3 = deriv(state_add(state, k2, dt * 0.5));
+    StateDerivative k4 = deriv(state_add(state, k3, dt));
+
+    // Weighted sum: y_{n+1} = y_n + (dt/6)(k1 + 2k2 + 2k3 + k4)
+    State result = state_add(state, k1 + 2.0 * k2 + 2.0 * k3 + k4, dt / 6.0);
+    result.time = state.time + dt;
+    return result;
+}
+
+template <typename State, typename Deriv>
+State rk4_step(
+    const State& state,
+    double dt,
+    const Deriv& deriv)
+{
+    return rk4_step(state, deriv(state), dt, deriv);
+}
+
+/// Cubic Hermite dense output for a step without its own continuous
+/// extension (RK4): needs the derivatives f0 at y0 and f1 at y1
+template <typename State, typename StateDerivative>
+BasicDenseOutput<State, StateDerivative> hermite_dense_output(
+    const State& y0, const StateDerivative& f0,
+    const State& y1, const StateDerivative& f1)
+{
+    BasicDenseOutput<State, StateDerivative> d;
+    d.y0 = y0;
+    d.h = y1.time - y0.time;
+    d.ydiff = state_diff(y1, y0);
+    d.bspl = d.h * f0 - d.ydiff;
+    d.c4 = d.ydiff - d.h * f1 - d.bspl;
+    d.c5 = 0.0 * d.ydiff;
+    return d;
+}
+
+/// State at time t in [y0.time, y0.time + h] from a dense output
+template <typename State, typename StateDerivative>
+State dense_evaluate(const BasicDenseOutput<State, StateDerivative>& d, double t)
+{
+    if (d.h == 0.0) return d.y0;
+
+    double theta = (t - d.y0.time) / d.h;
+    double theta1 = 1.0 - theta;
+    State y = state_add(d.y0,
+        theta * (d.ydiff + theta1 * (d.bspl + theta * (d.c4 + theta1 * d.c5))), 1.0);
+    y.time = t;
+    return y;
+}
+
+template <typename State, typename StateDerivative, typename Deriv>
+BasicAdaptiveStepResult<State, StateDerivative> dopri5_step(
+    const State& state,
+    const StateDerivative& k1,
+    double dt,
+    const Deriv& deriv,
+    const IntegratorConfig& config,
+    BasicDenseOutput<State, StateDerivative>* dense = nullptr)
+{
+    using namespace detail;
+
+    BasicAdaptiveStepResult<State, StateDerivative> result = {};
+    dt = std::clamp(dt, config.dt_min, config.dt_max);
+
+    for (;;) {
+        StateDerivative k2 = deriv(state_add(state, dp_a21 * k1, dt));
+        StateDerivative k3 = deriv(state_add(state, dp_a31 * k1 + dp_a32 * k2, dt));
+        StateDerivative k4 = deriv(state_add(state,
+            dp_a41 * k1 + dp_a42 * k2 + dp_a43 * k3, dt));
+        StateDerivative k5 = deriv(state_add(state,
+            dp_a51 * k1 + dp_a52 * k2 + dp_a53 * k3 + dp_a54 * k4, dt));
+        StateDerivative k6 = deriv(state_add(state,
+            dp_a61 * k1 + dp_a62 * k2 + dp_a63 * k3 + dp_a64 * k4 + dp_a65 * k5, dt));
+
+        // 5th-order solution; its derivative is the first stage of the next step
+        State y1 = state_add(state,
+            dp_a71 * k1 + dp_a73 * k3 + dp_a74 * k4 + dp_a75 * k5 + dp_a76 * k6, dt);
+        StateDerivative k7 = deriv(y1);
+        result.evaluations += 6;
+
+        StateDerivative err = dt * (dp_e1 * k1 + dp_e3 * k3 + dp_e4 * k4 +
+                                    dp_e5 * k5 + dp_e6 * k6 + dp_e7 * k7);
+        double err_norm = scaled_error(state, y1, err, config.abs_tol, config.rel_tol);
+
+        // Optimal scale for a 5th-order local error estimate: (1/err)^(1/5)
+        double scale = (err_norm > 0.0)
+            ? dp_safety * std::pow(err_norm, -0.2)
+            : dp_max_scale;
+
+        if (err_norm <= 1.0 || dt <= config.dt_min) {
+            // After a rejection, don't let the next step grow again immediately
+            double max_scale = (result.rejected > 0) ? 1.0 : dp_max_scale;
+            scale = std::clamp(scale, dp_min_scale, max_scale);
+
+            result.state = y1;
+            result.deriv_end = k7;
+            result.dt_taken = dt;
+            result.dt_next = std::clamp(dt * scale, config.dt_min, config.dt_max);
+            result.error_norm = err_norm;
+
+            if (dense) {
+                dense->y0 = state;
+                dense->h = dt;
+                dense->ydiff = state_diff(y1, state);
+                dense->bspl = dt * k1 - dense->ydiff;
+                dense->c4 = dense->ydiff - dt * k7 - dense->bspl;
+                dense->c5 = dt * (dp_d1 * k1 + dp_d3 * k3 + dp_d4 * k4 +
+                                  dp_d5 * k5 + dp_d6 * k6 + dp_d7 * k7);
+            }
+            return result;
+        }
+
+        result.rejected++;
+        dt = std::max(dt * std::max(scale, dp_min_scale), config.dt_min);
+    }
+}
 
 } // namespace bh
 
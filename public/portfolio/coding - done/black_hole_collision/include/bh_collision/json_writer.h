@@ -0,0 +1,107 @@
+/**
+ * @file json_writer.h
+ * @brief Buffered JSON output for export_to_json() and JsonFrameSink.
+ *
+ * Formatting through std::ostream costs a locale lookup and a small write
+ * per field, which made the JSON export slower than whole phases of the
+ * simulation. JsonWriter assembles the text in a reusable buffer, formats
+ * numbers with std::to_chars (shortest form that reads back to the same
+ * double), and hands the stream one large block at a time.
+ *
+ * The writer tracks nesting and separators itself, so callers only say what
+ * to write:
+ *
+ *   JsonWriter json(out, compact);
+ *   json.begin_object();
+ *   json.number("time", t);
+ *   json.vec3("position", p);
+ *   json.end_object();
+ *   json.flush();
+ *
+ * Pretty output puts each member on its own line, indented two spaces per
+ * level, with 3-vectors inline as "[x, y, z]". Compact output has no
+ * whitespace at all.
+ *
+ * A writer without a stream only fills text(). Together with
+ * continue_array() that lets other threads format slices of one array.
+ */
+
+#ifndef BH_COLLISION_JSON_WRITER_H
+#define BH_COLLISION_JSON_WRITER_H
+
+#include "simulation.h"
+#include <glm/glm.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bh {
+
+class JsonWriter {
+public:
+    /// Bytes buffered before they are written to the stream
+    static constexpr size_t FLUSH_BYTES = 1 << 20;
+
+    explicit JsonWriter(std::ostream& out, bool compact = false);
+
+    /// Writer that keeps everything in text() and never flushes
+    explicit JsonWriter(bool compact);
+
+    ~JsonWriter() { flush(); }
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    /// Containers; key is the member name inside an object, nullptr for
+    /// array elements and the root
+    void begin_object(const char* key = nullptr);
+    void end_object();
+    void begin_array(const char* key = nullptr);
+    void end_array();
+
+    // Values
+    void number(const char* key, double value);
+    void number(const char* key, long long value);
+    void boolean(const char* key, bool value);
+    void string(const char* key, const char* value);   // value is not escaped
+    void vec3(const char* key, const glm::dvec3& v);
+
+    /// Text the writer cannot structure itself (e.g. a document ending)
+    void raw(const char* text);
+
+    /// Carry on inside an array opened by another writer, depth containers
+    /// deep (the root counts as one). has_items says whether elements came
+    /// before, i.e. whether the next one needs a separator.
+    void continue_array(size_t depth, bool has_items);
+
+    /// Text formatted but not yet flushed
+    std::string& text() { return buffer_; }
+
+    /// Write the buffered text; returns false if the stream has failed
+    bool flush();
+
+private:
+    void begin_value(const char* key);
+    void close_container(char bracket);
+    void append_number(double value);
+    void maybe_flush() { if (out_ && buffer_.size() >= FLUSH_BYTES) flush(); }
+
+    std::ostream* out_;
+    bool compact_;
+    std::string buffer_;
+    std::vector<bool> has_items_;   // Per open container: written an element yet?
+};
+
+namespace detail {
+
+/// One element of the JSON "frames" array
+void write_json_frame(JsonWriter& json, const SimulationFrame& f);
+
+/// The "metadata", "config" and (after a merger) "remnant" members
+void write_json_summary(JsonWriter& json, const SimulationResult& result, size_t num_frames);
+
+} // namespace detail
+
+} // namespace bh
+
+#endif // BH_COLLISION_JSON_WRITER_H
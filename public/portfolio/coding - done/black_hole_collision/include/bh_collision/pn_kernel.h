@@ -0,0 +1,202 @@
+/**
+ * @file pn_kernel.h
+ * @brief Compile-time specialized post-Newtonian acceleration kernels for the
+ *        integrator hot loop.
+ *
+ * compute_relative_acceleration() in physics.h decides which PN orders to
+ * evaluate from runtime flags and reports each order separately. The kernels
+ * here fix the enabled orders as template parameters, share the common
+ * subexpressions (M/r, rdot^2, v^4) between orders and return only the total
+ * acceleration, so a Newtonian-only or 1PN-only run carries no dead work or
+ * branches in its innermost loop. Pick the specialization once per run with
+ * dispatch_pn_order(), and the mass-ratio coefficients with
+ * make_pn_coefficients().
+ */
+
+#ifndef BH_COLLISION_PN_KERNEL_H
+#define BH_COLLISION_PN_KERNEL_H
+
+#include "compiler.h"
+#include <glm/glm.hpp>
+#include <cmath>
+
+namespace bh {
+
+/// Tag naming a combination of enabled PN orders
+template <bool PN1, bool PN2, bool PN25>
+struct PNOrderTag {
+    static constexpr bool enable_1pn = PN1;
+    static constexpr bool enable_2pn = PN2;
+    static constexpr bool enable_25pn = PN25;
+};
+
+/// Mass-dependent coefficients of the PN equations of motion. They are
+/// constant for a run, so build them once with make_pn_coefficients()
+/// instead of re-deriving eta and its polynomials on every evaluation.
+struct PNCoefficients {
+    double M;           // Total mass m1 + m2
+    double eta;         // Symmetric mass ratio m1*m2/M^2
+    double m1_over_M;   // Converts a_rel to body 2: a2 = -(m1/M) a_rel
+    double m2_over_M;   // Converts a_rel to body 1: a1 =  (m2/M) a_rel
+
+    // 1PN
+    double pn1_Mr;          // 2(2 + eta)
+    double pn1_rdot2;       // (3/2) eta
+    double pn1_v;           // 2(2 - eta)
+
+    // 2PN, radial (n) part
+    double pn2_Mr2;         // -2(2 + 25 eta + 2 eta^2)
+    double pn2_v4;          // (3/2) eta (3 - 4 eta), also the v^2 rdot^2 term
+    double pn2_Mr_v2;       // (1/2) eta (13 - 4 eta)
+    double pn2_Mr_rdot2;    // -(2 + 15 eta - 2 eta^2)
+    double pn2_rdot4;       // -(15/8) eta (1 - 3 eta)
+
+    // 2PN, tangential (v) part
+    double pn2_v2_rdot;     // -(1/2) eta (15 + 4 eta)
+    double pn2_Mr_rdot;     // 4 + 41 eta / 4 + eta^2
+    double pn2_rdot3;       // (3/2) eta (3 + 2 eta)
+
+    // 2.5PN
+    double pn25_prefactor;  // (8/5) eta M
+};
+
+inline PNCoefficients make_pn_coefficients(double m1, double m2) {
+    PNCoefficients c;
+    double M = m1 + m2;
+    double eta = m1 * m2 / (M * M);
+
+    c.M = M;
+    c.eta = eta;
+    c.m1_over_M = m1 / M;
+    c.m2_over_M = m2 / M;
+
+    c.pn1_Mr = 2.0 * (2.0 + eta);
+    c.pn1_rdot2 = 1.5 * eta;
+    c.pn1_v = 2.0 * (2.0 - eta);
+
+    c.pn2_Mr2 = -2.0 * (2.0 + 25.0 * eta + 2.0 * eta * eta);
+    c.pn2_v4 = 1.5 * eta * (3.0 - 4.0 * eta);
+    c.pn2_Mr_v2 = 0.5 * eta * (13.0 - 4.0 * eta);
+    c.pn2_Mr_rdot2 = -(2.0 + 15.0 * eta - 2.0 * eta * eta);
+    c.pn2_rdot4 = -1.875 * eta * (1.0 - 3.0 * eta);
+
+    c.pn2_v2_rdot = -0.5 * eta * (15.0 + 4.0 * eta);
+    c.pn2_Mr_rdot = 4.0 + 41.0 * eta / 4.0 + eta * eta;
+    c.pn2_rdot3 = 1.5 * eta * (3.0 + 2.0 * eta);
+
+    c.pn25_prefactor = 8.0 / 5.0 * eta * M;
+    return c;
+}
+
+/// Kernel body without the r -> 0 guard. Branch-free, so loops over many
+/// binaries (batch.h) vectorize; callers must mask r < 1e-10 themselves.
+template <bool PN1, bool PN2, bool PN25>
+BH_FORCEINLINE glm::dvec3 pn_relative_acceleration_unguarded(
+    const glm::dvec3& r,
+    const glm::dvec3& v,
+    double r2, double r_mag,
+    const PNCoefficients& c)
+{
+    glm::dvec3 n = r / r_mag;
+
+    // Newtonian: a_N = -M/r^2 * n
+    glm::dvec3 a = -c.M / r2 * n;
+
+    if constexpr (PN1 || PN2 || PN25) {
+        double Mr = c.M / r_mag;
+        double v2 = glm::dot(v, v);
+        double rdot = glm::dot(n, v);
+        double rdot2 = rdot * rdot;
+
+        if constexpr (PN1) {
+            double n_coeff = -v2 + c.pn1_Mr * Mr + c.pn1_rdot2 * rdot2;
+            double v_coeff = c.pn1_v * rdot;
+
+            a += -Mr / r_mag * (n_coeff * n + v_coeff * v);
+        }
+
+        if constexpr (PN2) {
+            double Mr2 = Mr * Mr;
+            double v4 = v2 * v2;
+
+            double n_coeff =
+                c.pn2_Mr2 * Mr2
+                + c.pn2_v4 * v4
+                + c.pn2_Mr_v2 * Mr * v2
+                + c.pn2_Mr_rdot2 * Mr * rdot2
+                + c.pn2_rdot4 * rdot2 * rdot2
+                + c.pn2_v4 * v2 * rdot2;
+
+            double v_coeff =
+                c.pn2_v2_rdot * v2 * rdot
+                + c.pn2_Mr_rdot * Mr * rdot
+                + c.pn2_rdot3 * rdot * rdot2;
+
+            a += -Mr / r_mag * (n_coeff * n + v_coeff * v);
+        }
+
+        if constexpr (PN25) {
+            double prefactor = c.pn25_prefactor * Mr / r2;
+
+            double n_coeff = rdot * (18.0 * v2 + (2.0 / 3.0) * Mr - 25.0 * rdot2);
+            double v_coeff = -(6.0 * v2 - 2.0 * Mr - 15.0 * rdot2);
+
+            a += prefactor * (n_coeff * n + v_coeff * v);
+        }
+    }
+
+    return a;
+}
+
+/// Total relative acceleration for the orders fixed at compile time.
+/// Same equations as compute_relative_acceleration() (see physics.cpp).
+template <bool PN1, bool PN2, bool PN25>
+BH_FORCEINLINE glm::dvec3 pn_relative_acceleration(
+    const glm::dvec3& r,       // relative position r = x1 - x2
+    const glm::dvec3& v,       // relative velocity v = v1 - v2
+    const PNCoefficients& c)
+{
+    double r2 = glm::dot(r, r);
+    double r_mag = std::sqrt(r2);
+
+    if (r_mag < 1e-10) {
+        return glm::dvec3(0.0);  // Avoid singularity
+    }
+
+    return pn_relative_acceleration_unguarded<PN1, PN2, PN25>(r, v, r2, r_mag, c);
+}
+
+/// Convenience overload for one-off evaluations; integration loops should
+/// build the coefficients once and use the overload above.
+template <bool PN1, bool PN2, bool PN25>
+inline glm::dvec3 pn_relative_acceleration(
+    const glm::dvec3& r,
+    const glm::dvec3& v,
+    double m1, double m2)
+{
+    return pn_relative_acceleration<PN1, PN2, PN25>(r, v, make_pn_coefficients(m1, m2));
+}
+
+/// Call f(PNOrderTag<...>{}) with the tag matching the runtime flags.
+/// Intended to be called once per run, outside the integration loop.
+template <typename F>
+decltype(auto) dispatch_pn_order(bool pn1, bool pn2, bool pn25, F&& f) {
+    if (pn1) {
+        if (pn2) {
+            if (pn25) return f(PNOrderTag<true, true, true>{});
+            return f(PNOrderTag<true, true, false>{});
+        }
+        if (pn25) return f(PNOrderTag<true, false, true>{});
+        return f(PNOrderTag<true, false, false>{});
+    }
+    if (pn2) {
+        if (pn25) return f(PNOrderTag<false, true, true>{});
+        return f(PNOrderTag<false, true, false>{});
+    }
+    if (pn25) return f(PNOrderTag<false, false, true>{});
+    return f(PNOrderTag<false, false, false>{});
+}
+
+} // namespace bh
+
+#endif // BH_COLLISION_PN_KERNEL_H
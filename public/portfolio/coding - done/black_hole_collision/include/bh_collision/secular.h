@@ -0,0 +1,75 @@
+/**
+ * @file secular.h
+ * @brief Orbit-averaged (secular) inspiral for wide binaries.
+ *
+ * Far from merger the orbit changes by a tiny amount per revolution, and
+ * following every orbit with the PN integrator costs thousands of steps per
+ * orbit. The Peters-Mathews equations evolve the orbit-averaged semi-major
+ * axis and eccentricity instead, with steps a small fraction of the
+ * radiation-reaction time a / |da/dt|. The orbital phase is carried along,
+ * so the hand-off to the full PN integrator continues the same orbit.
+ *
+ * References:
+ *   - Peters & Mathews, Phys. Rev. 131 (1963) 435
+ *   - Peters, Phys. Rev. 136 (1964) B1224
+ */
+
+#ifndef BH_COLLISION_SECULAR_H
+#define BH_COLLISION_SECULAR_H
+
+#include "integrator.h"
+
+namespace bh {
+
+/// Settings for the orbit-averaged fast-forward
+struct SecularConfig {
+    bool enabled = false;
+    double handoff_separation = 30.0;  // Hand off once a <= this (M)
+    double handoff_velocity = 0.0;     // ...or once v/c = sqrt(M/a) >= this (0 = off)
+    double step_fraction = 1e-3;       // Step size as a fraction of a / |da/dt|
+};
+
+/// Orbit-averaged state of a Keplerian binary
+struct SecularState {
+    double a;          // Semi-major axis
+    double e;          // Eccentricity
+    double phase;      // Mean anomaly, accumulated (not wrapped), radians
+    double periapsis;  // Angle of periapsis from +x in the x-z plane (fixed at this order)
+    double time;
+};
+
+/// Time derivative of SecularState
+struct SecularRates {
+    double da, de, dphase;
+};
+
+/// Peters (1964) rates for a binary of total mass M and symmetric mass ratio
+/// eta, plus the mean motion n = sqrt(M/a^3) for the phase
+SecularRates secular_rates(const SecularState& s, double eta, double total_mass);
+
+/// Advance by dt with classic RK4
+SecularState secular_step(const SecularState& s, double dt, double eta, double total_mass);
+
+/// State at time t in [s0.time, s1.time] between two consecutive steps
+/// (cubic Hermite in every component, using the rates at both ends)
+SecularState secular_interpolate(
+    const SecularState& s0, const SecularRates& r0,
+    const SecularState& s1, const SecularRates& r1,
+    double t
+);
+
+/// Secular state of the Keplerian orbit through r, v. The orbit must turn
+/// the way init_binary sets it up (from +x towards +z).
+SecularState secular_from_relative(const RelativeState& rel, double total_mass);
+
+/// Relative position and velocity on the Keplerian orbit (a, e) at the given
+/// mean anomaly, in the x-z orbital plane
+RelativeState relative_from_secular(const SecularState& s, double total_mass);
+
+/// True once the configured hand-off separation or velocity is reached
+bool secular_should_handoff(const SecularState& s, const SecularConfig& config,
+                            double total_mass);
+
+} // namespace bh
+
+#endif // BH_COLLISION_SECULAR_H
@@ -11,12 +11,18 @@
 #include "physics.h"
 #include "merger.h"
 #include "integrator.h"
+#include "secular.h"
+#include "recording.h"
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
 
 namespace bh {
 
+class FrameSink;  // frame_sink.h
+class Executor;   // sweep.h
+
 /// A single snapshot of the simulation state
 struct SimulationFrame {
     double time;
@@ -26,6 +32,39 @@ struct SimulationFrame {
     int phase;  // 0=inspiral, 1=merger, 2=ringdown, 3=post-ringdown
 };
 
+/// Timers and step-size extremes in SimulationStats cost a few clock reads
+/// per phase and one per 16 frames; build with BH_ENABLE_STATS=0 to leave
+/// them at zero. The work counters are always kept.
+#ifndef BH_ENABLE_STATS
+#define BH_ENABLE_STATS 1
+#endif
+
+/// Work counters and wall-clock timers of a run
+struct SimulationStats {
+    long long integrator_steps = 0;        // Accepted PN steps
+    long long rejected_steps = 0;          // DP54 attempts the error control rejected
+    long long derivative_evaluations = 0;  // PN equation-of-motion evaluations
+    long long secular_steps = 0;           // Orbit-averaged fast-forward steps
+    long long frames_recorded = 0;         // Frames pushed to the sink, all phases
+
+    // Accepted PN step sizes (M)
+    double min_dt = 0.0;
+    double max_dt = 0.0;
+
+    // Wall time (s) of each phase, including the time the sink takes
+    double secular_seconds = 0.0;
+    double inspiral_seconds = 0.0;
+    double merger_seconds = 0.0;           // Remnant and QNM fit
+    double ringdown_seconds = 0.0;
+    double total_seconds = 0.0;            // Whole run, with the sink's finish();
+                                           // the sink itself sees the time before it
+
+    /// Building inspiral and merger frames from the state (observables and
+    /// strain), part of the phase times. Estimated from every 16th frame.
+    double make_frame_seconds = 0.0;
+    long long make_frame_calls = 0;
+};
+
 /// Complete result of a simulation run
 struct SimulationResult {
     std::vector<SimulationFrame> frames;
@@ -38,6 +77,7 @@ struct SimulationResult {
     bool merger_occurred;
     int num_inspiral_frames;
     int num_ringdown_frames;
+    SimulationStats stats;
 };
 
 /// Progress callback: called periodically with (current_time, fraction_complete, phase_name)
@@ -47,9 +87,14 @@ using ProgressCallback = std::function<void(double, double, const char*)>;
 struct SimulationConfig {
     BinaryConfig binary;
     IntegratorConfig integrator;
+    SecularConfig secular;          // Orbit-averaged fast-forward of the early inspiral
 
     double max_time = 1e6;          // Maximum simulation time in M
     double record_interval = 10.0;  // Time between recorded frames in M
+
+    /// Inspiral frame times (recording.h). Null keeps the classic cadence:
+    /// record_interval, 4000x finer below 10 M separation.
+    std::shared_ptr<const RecordingPolicy> recording;
     double ringdown_duration = 100.0; // How long to simulate ringdown in M_f
     int ringdown_samples = 500;     // Number of ringdown waveform samples
 
@@ -63,11 +108,32 @@ struct SimulationConfig {
     ProgressCallback progress_callback = nullptr;
 };
 
+/// Set up the two black holes from the configuration: center of mass at
+/// rest at the origin, separated along x, orbiting in the x-z plane
+void init_binary(const BinaryConfig& config, BlackHole& bh1, BlackHole& bh2);
+
 /// Run a complete binary black hole merger simulation
 SimulationResult run_simulation(const SimulationConfig& config);
 
+/// Run the simulation, handing each frame to sink as it is recorded instead
+/// of storing it (see frame_sink.h). The returned result has no frames;
+/// num_inspiral_frames and num_ringdown_frames count what the sink received.
+SimulationResult run_simulation(const SimulationConfig& config, FrameSink& sink);
+
+/// JSON export settings
+struct ExportOptions {
+    bool compact = false;   // No indentation or line breaks
+
+    /// Formats slices of chunk_frames frames on the executor's threads and
+    /// writes them in order; the file is the same as from one thread.
+    /// nullptr formats everything on the calling thread.
+    Executor* executor = nullptr;
+    size_t chunk_frames = 4096;
+};
+
 /// Export simulation results to JSON file
-bool export_to_json(const SimulationResult& result, const std::string& filename);
+bool export_to_json(const SimulationResult& result, const std::string& filename,
+                    const ExportOptions& options = {});
 
 /// Print a summary of the simulation results to stdout
 void print_summary(const SimulationResult& result);
@@ -0,0 +1,110 @@
+/**
+ * @file sweep.h
+ * @brief Parameter sweeps: many full simulations spread over worker threads.
+ *
+ * run_simulation() is single-threaded, and one run is a poor unit of
+ * parallelism on its own. A sweep over masses, spins and separations has
+ * plenty of independent runs, but their durations differ by orders of
+ * magnitude (a wide, unequal-mass binary takes far longer than a close
+ * equal-mass one), so handing each thread a fixed slice of the grid leaves
+ * most threads idle while one finishes its slow slice. WorkStealingExecutor
+ * gives every worker its own queue and lets idle workers take jobs from the
+ * back of a busy worker's queue.
+ */
+
+#ifndef BH_COLLISION_SWEEP_H
+#define BH_COLLISION_SWEEP_H
+
+#include "simulation.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bh {
+
+/// Runs independent tasks, possibly concurrently
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    /// Call task(i) once for every i in [0, count) and return when all calls
+    /// have finished. Tasks must not throw or call parallel_for themselves.
+    /// Several threads may call parallel_for on one executor; the calls run
+    /// one after another.
+    virtual void parallel_for(size_t count, const std::function<void(size_t)>& task) = 0;
+
+    /// Number of tasks that may run at the same time
+    virtual unsigned concurrency() const = 0;
+};
+
+/// Runs every task on the calling thread, in index order
+class SerialExecutor : public Executor {
+public:
+    void parallel_for(size_t count, const std::function<void(size_t)>& task) override;
+    unsigned concurrency() const override { return 1; }
+};
+
+/// Fixed pool of worker threads with one task queue each. parallel_for
+/// deals the indices out in contiguous blocks; a worker takes from the front
+/// of its own queue and, once that is empty, steals from the back of the
+/// others'.
+class WorkStealingExecutor : public Executor {
+public:
+    /// num_threads = 0 uses std::thread::hardware_concurrency()
+    explicit WorkStealingExecutor(unsigned num_threads = 0);
+    ~WorkStealingExecutor() override;
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    void parallel_for(size_t count, const std::function<void(size_t)>& task) override;
+    unsigned concurrency() const override { return (unsigned)threads_.size(); }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void worker_loop(unsigned id);
+    bool pop_or_steal(unsigned id, size_t& index);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    // Held for a whole parallel_for, so concurrent callers take turns with
+    // the single task_ and remaining_ below
+    std::mutex call_mutex_;
+
+    // Guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable wake_;      // New tasks or shutdown
+    std::condition_variable done_;      // remaining_ reached zero
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t remaining_ = 0;
+    unsigned long long generation_ = 0; // Incremented by every parallel_for
+    bool stopping_ = false;
+};
+
+/// Called as each sweep job finishes, one call at a time, in completion order
+using SweepCallback = std::function<void(size_t index, const SimulationResult& result)>;
+
+/// Run every configuration on the executor. Results are returned in config
+/// order and also passed to on_result as soon as each job finishes. Frames
+/// are discarded as they are recorded (the frame counters are still set)
+/// unless keep_frames is true. Progress callbacks in the configs are called
+/// from the worker threads.
+std::vector<SimulationResult> run_sweep(
+    const std::vector<SimulationConfig>& configs,
+    Executor& executor,
+    const SweepCallback& on_result = nullptr,
+    bool keep_frames = false
+);
+
+} // namespace bh
+
+#endif // BH_COLLISION_SWEEP_H
@@ -0,0 +1,329 @@
+/**
+ * @file batch.cpp
+ * @brief Batched RK4 inspiral engine (structure-of-arrays, lane-parallel).
+ */
+
+#include "bh_collision/batch.h"
+#include "bh_collision/integrator.h"
+#include "bh_collision/merger.h"
+#include "bh_collision/pn_kernel.h"
+#include "bh_collision/compiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace bh {
+
+namespace {
+
+constexpr int W = BinaryStateBatch::width;
+
+/// Per-lane constants, set when a lane is (re)filled
+struct LaneParams {
+    PNCoefficients coeffs[W];
+    alignas(64) double total_mass[W];
+    alignas(64) double safety_factor[W];
+    alignas(64) double dt_min[W];
+    alignas(64) double dt_max[W];
+    alignas(64) double max_time[W];
+    alignas(64) double r_merge[W];     // Merger separation (see should_merge)
+    long long job[W];                  // Index into configs, -1 if idle
+    long long steps[W];
+};
+
+/// Relative position and velocity of every lane, for the RK4 stages
+struct LaneVectors {
+    alignas(64) double r[3][W];
+    alignas(64) double v[3][W];
+};
+
+// ============================================================================
+// Lane kernels
+//
+// Each loop body is the scalar code for one binary; the loops over lanes
+// carry no dependencies, so the compiler turns them into vector code.
+// ============================================================================
+
+template <typename Order>
+BH_FORCEINLINE void batch_acceleration(
+    const LaneVectors& y, const PNCoefficients* coeffs, double (&a)[3][W])
+{
+    for (int l = 0; l < W; l++) {
+        glm::dvec3 r(y.r[0][l], y.r[1][l], y.r[2][l]);
+        glm::dvec3 v(y.v[0][l], y.v[1][l], y.v[2][l]);
+
+        // pn_relative_acceleration() with its singularity guard done in
+        // arithmetic: evaluate at a safe radius, then zero the lane. A select
+        // gets turned back into a branch around the kernel, which blocks
+        // vectorization.
+        double r2 = glm::dot(r, r);
+        double r_mag = std::sqrt(r2);
+        double keep = (double)(r_mag >= 1e-10);
+        double r_safe = std::max(r_mag, 1e-10);
+        double r2_safe = std::max(r2, 1e-20);
+        glm::dvec3 acc = pn_relative_acceleration_unguarded<
+            Order::enable_1pn, Order::enable_2pn, Order::enable_25pn>(r, v, r2_safe, r_safe, coeffs[l]);
+
+        a[0][l] = acc.x * keep;
+        a[1][l] = acc.y * keep;
+        a[2][l] = acc.z * keep;
+    }
+}
+
+/// y = y0 + h * (dr, dv), per lane
+BH_FORCEINLINE void batch_stage(
+    const BinaryStateBatch& y0,
+    const double (&dr)[3][W], const double (&dv)[3][W],
+    const double* h, LaneVectors& y)
+{
+    for (int c = 0; c < 3; c++) {
+        for (int l = 0; l < W; l++) {
+            y.r[c][l] = y0.r[c][l] + dr[c][l] * h[l];
+            y.v[c][l] = y0.v[c][l] + dv[c][l] * h[l];
+        }
+    }
+}
+
+/// One RK4 step of every lane with its own dt. Same arithmetic as
+/// rk4_step() on a RelativeState; lanes with dt = 0 stay put.
+template <typename Order>
+void batch_rk4_step(BinaryStateBatch& s, const double* dt, const PNCoefficients* coeffs)
+{
+    alignas(64) double half[W], sixth[W];
+    for (int l = 0; l < W; l++) {
+        half[l] = dt[l] * 0.5;
+        sixth[l] = dt[l] / 6.0;
+    }
+
+    LaneVectors y;
+    alignas(64) double k1v[3][W], k2r[3][W], k2v[3][W], k3r[3][W], k3v[3][W];
+    alignas(64) double k4r[3][W], k4v[3][W];
+
+    // k1 = f(y0); its position part is s.v itself
+    for (int c = 0; c < 3; c++) {
+        for (int l = 0; l < W; l++) {
+            y.r[c][l] = s.r[c][l];
+            y.v[c][l] = s.v[c][l];
+        }
+    }
+    batch_acceleration<Order>(y, coeffs, k1v);
+
+    // k2 = f(y0 + dt/2 k1)
+    batch_stage(s, s.v, k1v, half, y);
+    for (int c = 0; c < 3; c++) {
+        for (int l = 0; l < W; l++) k2r[c][l] = y.v[c][l];
+    }
+    batch_acceleration<Order>(y, coeffs, k2v);
+
+    // k3 = f(y0 + dt/2 k2)
+    batch_stage(s, k2r, k2v, half, y);
+    for (int c = 0; c < 3; c++) {
+        for (int l = 0; l < W; l++) k3r[c][l] = y.v[c][l];
+    }
+    batch_acceleration<Order>(y, coeffs, k3v);
+
+    // k4 = f(y0 + dt k3)
+    batch_stage(s, k3r, k3v, dt, y);
+    for (int c = 0; c < 3; c++) {
+        for (int l = 0; l < W; l++) k4r[c][l] = y.v[c][l];
+    }
+    batch_acceleration<Order>(y, coeffs, k4v);
+
+    // y_{n+1} = y_n + (dt/6)(k1 + 2k2 + 2k3 + k4)
+    for (int c = 0; c < 3; c++) {
+        for (int l = 0; l < W; l++) {
+            s.r[c][l] += (s.v[c][l] + 2.0 * k2r[c][l] + 2.0 * k3r[c][l] + k4r[c][l]) * sixth[l];
+            s.v[c][l] += (k1v[c][l] + 2.0 * k2v[c][l] + 2.0 * k3v[c][l] + k4v[c][l]) * sixth[l];
+        }
+    }
+    for (int l = 0; l < W; l++) {
+        s.time[l] += dt[l];
+    }
+}
+
+// ============================================================================
+// Lane bookkeeping
+// ============================================================================
+
+/// Park a lane: harmless state that a zero step leaves unchanged
+void clear_lane(BinaryStateBatch& s, LaneParams& p, int l)
+{
+    for (int c = 0; c < 3; c++) {
+        s.r[c][l] = (c == 0) ? 1.0 : 0.0;
+        s.v[c][l] = 0.0;
+    }
+    s.time[l] = 0.0;
+    p.coeffs[l] = make_pn_coefficients(0.5, 0.5);
+    p.total_mass[l] = 1.0;
+    p.safety_factor[l] = 0.0;
+    p.dt_min[l] = p.dt_max[l] = 0.0;
+    p.max_time[l] = 0.0;
+    p.r_merge[l] = 0.0;
+    p.job[l] = -1;
+    p.steps[l] = 0;
+}
+
+/// Load configuration `job` into lane l, with the initial conditions of
+/// run_simulation()
+void fill_lane(BinaryStateBatch& s, LaneParams& p, int l,
+               const SimulationConfig& config, long long job)
+{
+    BlackHole bh1, bh2;
+    init_binary(config.binary, bh1, bh2);
+
+    glm::dvec3 r = bh1.position - bh2.position;
+    glm::dvec3 v = bh1.velocity - bh2.velocity;
+    for (int c = 0; c < 3; c++) {
+        s.r[c][l] = r[c];
+        s.v[c][l] = v[c];
+    }
+    s.time[l] = 0.0;
+
+    const IntegratorConfig& ic = config.integrator;
+    p.coeffs[l] = make_pn_coefficients(bh1.mass, bh2.mass);
+    p.total_mass[l] = bh1.mass + bh2.mass;
+    if (ic.adaptive) {
+        p.safety_factor[l] = ic.safety_factor;
+        p.dt_min[l] = ic.dt_min;
+        p.dt_max[l] = ic.dt_max;
+    } else {
+        // Clamping to [dt_initial, dt_initial] gives a fixed step
+        p.safety_factor[l] = 0.0;
+        p.dt_min[l] = p.dt_max[l] = ic.dt_initial;
+    }
+    p.max_time[l] = config.max_time;
+    p.r_merge[l] = 0.5 * (bh1.schwarzschild_radius() + bh2.schwarzschild_radius()) / 2.0;
+    p.job[l] = job;
+    p.steps[l] = 0;
+}
+
+/// Record the outcome of the binary in lane l
+BatchInspiralResult retire_lane(const BinaryStateBatch& s, const LaneParams& p, int l,
+                                const SimulationConfig& config, bool merged)
+{
+    BatchInspiralResult out = {};
+    glm::dvec3 r(s.r[0][l], s.r[1][l], s.r[2][l]);
+    glm::dvec3 v(s.v[0][l], s.v[1][l], s.v[2][l]);
+
+    out.merger_occurred = merged;
+    out.merger_time = s.time[l];
+    out.final_separation = glm::length(r);
+    out.steps = p.steps[l];
+
+    if (merged) {
+        // Bodies in the COM frame, as run_simulation() hands them to the remnant fits
+        BlackHole bh1, bh2;
+        init_binary(config.binary, bh1, bh2);
+        const PNCoefficients& c = p.coeffs[l];
+        bh1.position = c.m2_over_M * r;
+        bh1.velocity = c.m2_over_M * v;
+        bh2.position = -c.m1_over_M * r;
+        bh2.velocity = -c.m1_over_M * v;
+        out.remnant = compute_remnant(bh1, bh2);
+    }
+    return out;
+}
+
+// ============================================================================
+// Drive one group of configurations sharing the same PN orders
+// ============================================================================
+
+template <typename Order>
+void run_group(const std::vector<SimulationConfig>& configs,
+               const std::vector<long long>& queue,
+               std::vector<BatchInspiralResult>& results)
+{
+    BinaryStateBatch s;
+    LaneParams p;
+    size_t next = 0;
+
+    for (int l = 0; l < W; l++) {
+        if (next < queue.size()) {
+            fill_lane(s, p, l, configs[queue[next]], queue[next]);
+            next++;
+        } else {
+            clear_lane(s, p, l);
+        }
+    }
+
+    alignas(64) double dt[W];
+    alignas(64) int done[W];
+
+    for (;;) {
+        // Same stopping rules as the inspiral loop in run_simulation():
+        // out of time, merger (should_merge), or the step limit
+        for (int l = 0; l < W; l++) {
+            double r2 = s.r[0][l] * s.r[0][l] + s.r[1][l] * s.r[1][l] + s.r[2][l] * s.r[2][l];
+            double v2 = s.v[0][l] * s.v[0][l] + s.v[1][l] * s.v[1][l] + s.v[2][l] * s.v[2][l];
+            int merged = (std::sqrt(r2) <= p.r_merge[l]) | (std::sqrt(v2) > 2.0);
+            int timed_out = s.time[l] >= p.max_time[l];
+            done[l] = timed_out ? 1 : 2 * merged;
+        }
+
+        int active = 0;
+        for (int l = 0; l < W; l++) {
+            if (p.job[l] < 0) continue;
+            if (done[l] || p.steps[l] > 2000000000) {
+                const SimulationConfig& config = configs[p.job[l]];
+                results[p.job[l]] = retire_lane(s, p, l, config, done[l] == 2);
+
+                // Refill from the work queue; the new lane starts on the next pass
+                if (next < queue.size()) {
+                    fill_lane(s, p, l, configs[queue[next]], queue[next]);
+                    next++;
+                } else {
+                    clear_lane(s, p, l);
+                    continue;
+                }
+            }
+            active++;
+        }
+        if (active == 0) break;
+
+        // Per-lane adaptive time step; idle lanes get dt = 0
+        for (int l = 0; l < W; l++) {
+            double sep = std::sqrt(s.r[0][l] * s.r[0][l] + s.r[1][l] * s.r[1][l] +
+                                   s.r[2][l] * s.r[2][l]);
+            dt[l] = orbital_timestep(sep, p.safety_factor[l], p.dt_min[l], p.dt_max[l],
+                                     p.total_mass[l]);
+        }
+
+        batch_rk4_step<Order>(s, dt, p.coeffs);
+
+        for (int l = 0; l < W; l++) {
+            p.steps[l] += (p.job[l] >= 0) ? 1 : 0;
+        }
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// Public entry point
+// ============================================================================
+
+std::vector<BatchInspiralResult> run_inspiral_batch(
+    const std::vector<SimulationConfig>& configs)
+{
+    std::vector<BatchInspiralResult> results(configs.size());
+
+    // Lanes in a batch share one kernel, so group the work queue by PN orders
+    std::vector<long long> queues[8];
+    for (size_t i = 0; i < configs.size(); i++) {
+        const SimulationConfig& c = configs[i];
+        int mask = (c.enable_1pn ? 1 : 0) | (c.enable_2pn ? 2 : 0) | (c.enable_25pn ? 4 : 0);
+        queues[mask].push_back((long long)i);
+    }
+
+    for (int mask = 0; mask < 8; mask++) {
+        if (queues[mask].empty()) continue;
+        dispatch_pn_order(mask & 1, mask & 2, mask & 4, [&](auto order) {
+            run_group<decltype(order)>(configs, queues[mask], results);
+        });
+    }
+
+    return results;
+}
+
+} // namespace bh
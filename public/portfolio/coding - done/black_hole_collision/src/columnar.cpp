@@ -0,0 +1,233 @@
+/**
+ * @file columnar.cpp
+ * @brief Conversions between frame records and columnar frame storage.
+ */
+
+#include "bh_collision/columnar.h"
+
+namespace bh {
+
+// ============================================================================
+// Per-field helpers
+// ============================================================================
+
+static void reserve_columns(Vec3Columns& c, size_t n)
+{
+    c.x.reserve(n);
+    c.y.reserve(n);
+    c.z.reserve(n);
+}
+
+static void clear_columns(Vec3Columns& c)
+{
+    c.x.clear();
+    c.y.clear();
+    c.z.clear();
+}
+
+static void push_columns(Vec3Columns& c, const glm::dvec3& v)
+{
+    c.x.push_back(v.x);
+    c.y.push_back(v.y);
+    c.z.push_back(v.z);
+}
+
+static glm::dvec3 read_columns(const Vec3Columns& c, size_t i)
+{
+    return glm::dvec3(c.x[i], c.y[i], c.z[i]);
+}
+
+static void reserve_columns(BodyColumns& c, size_t n)
+{
+    c.mass.reserve(n);
+    c.chi.reserve(n);
+    reserve_columns(c.position, n);
+    reserve_columns(c.velocity, n);
+    reserve_columns(c.spin_axis, n);
+}
+
+static void clear_columns(BodyColumns& c)
+{
+    c.mass.clear();
+    c.chi.clear();
+    clear_columns(c.position);
+    clear_columns(c.velocity);
+    clear_columns(c.spin_axis);
+}
+
+static void push_columns(BodyColumns& c, const BlackHole& bh)
+{
+    c.mass.push_back(bh.mass);
+    c.chi.push_back(bh.chi);
+    push_columns(c.position, bh.position);
+    push_columns(c.velocity, bh.velocity);
+    push_columns(c.spin_axis, bh.spin_axis);
+}
+
+static BlackHole read_columns(const BodyColumns& c, size_t i)
+{
+    BlackHole bh = {};
+    bh.mass = c.mass[i];
+    bh.chi = c.chi[i];
+    bh.position = read_columns(c.position, i);
+    bh.velocity = read_columns(c.velocity, i);
+    bh.spin_axis = read_columns(c.spin_axis, i);
+    return bh;
+}
+
+/// Run-level fields shared by SimulationResult and ColumnarResult
+template <typename From, typename To>
+static void copy_summary(const From& from, To& to)
+{
+    to.config = from.config;
+    to.remnant = from.remnant;
+    to.qnm = from.qnm;
+    to.merger_time = from.merger_time;
+    to.total_gw_cycles = from.total_gw_cycles;
+    to.total_energy_radiated = from.total_energy_radiated;
+    to.merger_occurred = from.merger_occurred;
+    to.num_inspiral_frames = from.num_inspiral_frames;
+    to.num_ringdown_frames = from.num_ringdown_frames;
+    to.stats = from.stats;
+}
+
+// ============================================================================
+// FrameColumns
+// ============================================================================
+
+void FrameColumns::reserve(size_t n)
+{
+    time.reserve(n);
+    phase.reserve(n);
+    reserve_columns(bh1, n);
+    reserve_columns(bh2, n);
+
+    separation.reserve(n);
+    orbital_frequency.reserve(n);
+    orbital_phase.reserve(n);
+    radial_velocity.reserve(n);
+    velocity_param.reserve(n);
+    reduced_mass.reserve(n);
+    total_mass.reserve(n);
+    symmetric_mass_ratio.reserve(n);
+    chirp_mass.reserve(n);
+    energy.reserve(n);
+    angular_momentum.reserve(n);
+
+    h_plus.reserve(n);
+    h_cross.reserve(n);
+    gw_amplitude.reserve(n);
+    gw_frequency.reserve(n);
+}
+
+void FrameColumns::clear()
+{
+    time.clear();
+    phase.clear();
+    clear_columns(bh1);
+    clear_columns(bh2);
+
+    separation.clear();
+    orbital_frequency.clear();
+    orbital_phase.clear();
+    radial_velocity.clear();
+    velocity_param.clear();
+    reduced_mass.clear();
+    total_mass.clear();
+    symmetric_mass_ratio.clear();
+    chirp_mass.clear();
+    energy.clear();
+    angular_momentum.clear();
+
+    h_plus.clear();
+    h_cross.clear();
+    gw_amplitude.clear();
+    gw_frequency.clear();
+}
+
+void FrameColumns::push_back(const SimulationFrame& f)
+{
+    time.push_back(f.time);
+    phase.push_back(f.phase);
+    push_columns(bh1, f.bh1);
+    push_columns(bh2, f.bh2);
+
+    separation.push_back(f.orbital.separation);
+    orbital_frequency.push_back(f.orbital.orbital_frequency);
+    orbital_phase.push_back(f.orbital.orbital_phase);
+    radial_velocity.push_back(f.orbital.radial_velocity);
+    velocity_param.push_back(f.orbital.velocity_param);
+    reduced_mass.push_back(f.orbital.reduced_mass);
+    total_mass.push_back(f.orbital.total_mass);
+    symmetric_mass_ratio.push_back(f.orbital.symmetric_mass_ratio);
+    chirp_mass.push_back(f.orbital.chirp_mass);
+    energy.push_back(f.orbital.energy);
+    angular_momentum.push_back(f.orbital.angular_momentum);
+
+    h_plus.push_back(f.gw.h_plus);
+    h_cross.push_back(f.gw.h_cross);
+    gw_amplitude.push_back(f.gw.amplitude);
+    gw_frequency.push_back(f.gw.frequency);
+}
+
+SimulationFrame FrameColumns::frame(size_t i) const
+{
+    SimulationFrame f;
+    f.time = time[i];
+    f.phase = phase[i];
+    f.bh1 = read_columns(bh1, i);
+    f.bh2 = read_columns(bh2, i);
+
+    f.orbital.separation = separation[i];
+    f.orbital.orbital_frequency = orbital_frequency[i];
+    f.orbital.orbital_phase = orbital_phase[i];
+    f.orbital.radial_velocity = radial_velocity[i];
+    f.orbital.velocity_param = velocity_param[i];
+    f.orbital.reduced_mass = reduced_mass[i];
+    f.orbital.total_mass = total_mass[i];
+    f.orbital.symmetric_mass_ratio = symmetric_mass_ratio[i];
+    f.orbital.chirp_mass = chirp_mass[i];
+    f.orbital.energy = energy[i];
+    f.orbital.angular_momentum = angular_momentum[i];
+
+    f.gw.h_plus = h_plus[i];
+    f.gw.h_cross = h_cross[i];
+    f.gw.amplitude = gw_amplitude[i];
+    f.gw.frequency = gw_frequency[i];
+    return f;
+}
+
+// ============================================================================
+// Conversions
+// ============================================================================
+
+ColumnarResult to_columnar(const SimulationResult& result)
+{
+    ColumnarResult columnar = {};
+    copy_summary(result, columnar);
+
+    columnar.frames.reserve(result.frames.size());
+    for (const auto& f : result.frames) {
+        columnar.frames.push_back(f);
+    }
+    return columnar;
+}
+
+SimulationResult to_result(const ColumnarResult& columnar)
+{
+    SimulationResult result = {};
+    copy_summary(columnar, result);
+
+    result.frames.reserve(columnar.frames.size());
+    for (size_t i = 0; i < columnar.frames.size(); i++) {
+        result.frames.push_back(columnar.frames.frame(i));
+    }
+    return result;
+}
+
+void ColumnarFrameSink::finish(const SimulationResult& summary)
+{
+    copy_summary(summary, result);
+}
+
+} // namespace bh
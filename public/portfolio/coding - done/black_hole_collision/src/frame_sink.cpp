@@ -0,0 +1,277 @@
+/**
+ * @file frame_sink.cpp
+ * @brief Stock frame sinks.
+ */
+
+#include "bh_collision/frame_sink.h"
+#include "bh_collision/integration_api.h"
+#include "bh_collision/trace.h"
+#include <cmath>
+
+namespace bh {
+
+// ============================================================================
+// JsonFrameSink
+// ============================================================================
+
+JsonFrameSink::JsonFrameSink(const std::string& filename, const ExportOptions& options)
+    : out_(filename), json_(out_, options.compact)
+{
+    if (!out_.is_open()) return;
+
+    json_.begin_object();
+    json_.begin_array("frames");
+}
+
+void JsonFrameSink::push(const SimulationFrame& frame)
+{
+    if (!out_.is_open()) return;
+
+    detail::write_json_frame(json_, frame);
+    num_frames_++;
+}
+
+void JsonFrameSink::finish(const SimulationResult& summary)
+{
+    if (!out_.is_open()) return;
+
+    json_.end_array();
+    detail::write_json_summary(json_, summary, num_frames_);
+    json_.end_object();
+    json_.raw("\n");
+    complete_ = json_.flush();
+    out_.close();
+    complete_ = complete_ && !out_.fail();
+}
+
+// ============================================================================
+// DecimatingFrameSink
+// ============================================================================
+
+void DecimatingFrameSink::push(const SimulationFrame& frame)
+{
+    if (frame.phase != 0) {
+        next_.push(frame);
+        return;
+    }
+
+    if (inspiral_seen_ % keep_every_ == 0) {
+        next_.push(frame);
+    }
+    inspiral_seen_++;
+}
+
+// ============================================================================
+// ErrorBoundedFrameSink
+// ============================================================================
+
+void ErrorBoundedFrameSink::push(const SimulationFrame& frame)
+{
+    uint64_t index = seen_++;
+
+    if (frame.phase != 0) {
+        // The inspiral is over: its last frame is kept, and nothing after it
+        // is dropped
+        drain();
+        window_.clear();
+        next_.push(frame);
+        source_indices_.push_back(index);
+        return;
+    }
+
+    window_.push_back(frame);
+    size_t last = window_.size() - 1;
+    if (last == 0) {
+        window_start_ = index;
+        keep(0);
+    } else if (last == 1) {
+        good_ = 1;   // Nothing in between to miss
+    } else if (last == 2 * good_ && !fits(last)) {
+        resolve(last);
+        return;
+    } else if (last == 2 * good_) {
+        good_ = last;
+    }
+
+    if (window_.size() > max_span_) resolve(window_.size());
+}
+
+void ErrorBoundedFrameSink::finish(const SimulationResult& summary)
+{
+    drain();
+    next_.finish(summary);
+}
+
+bool ErrorBoundedFrameSink::fits(size_t end) const
+{
+    const SimulationFrame& a = window_[0];
+    const SimulationFrame& b = window_[end];
+    double dt = b.time - a.time;
+    if (!(dt > 0)) return false;
+
+    for (size_t k = 1; k < end; k++) {
+        const SimulationFrame& f = window_[k];
+        double s = (f.time - a.time) / dt;
+
+        if (tolerances_.position > 0) {
+            glm::dvec3 p1 = detail::hermite_position(a.bh1.position, a.bh1.velocity,
+                                                     b.bh1.position, b.bh1.velocity, dt, s);
+            glm::dvec3 p2 = detail::hermite_position(a.bh2.position, a.bh2.velocity,
+                                                     b.bh2.position, b.bh2.velocity, dt, s);
+            if (glm::length(p1 - f.bh1.position) > tolerances_.position ||
+                glm::length(p2 - f.bh2.position) > tolerances_.position) {
+                return false;
+            }
+        }
+        if (tolerances_.h_plus > 0 &&
+            std::abs(a.gw.h_plus + s * (b.gw.h_plus - a.gw.h_plus) - f.gw.h_plus) > tolerances_.h_plus) {
+            return false;
+        }
+        if (tolerances_.h_cross > 0 &&
+            std::abs(a.gw.h_cross + s * (b.gw.h_cross - a.gw.h_cross) - f.gw.h_cross) > tolerances_.h_cross) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ErrorBoundedFrameSink::keep(size_t i)
+{
+    next_.push(window_[i]);
+    source_indices_.push_back(window_start_ + i);
+
+    window_.erase(window_.begin(), window_.begin() + (std::ptrdiff_t)i);
+    window_start_ += i;
+    good_ = 0;
+}
+
+void ErrorBoundedFrameSink::resolve(size_t bad)
+{
+    // good_ fits and bad does not (or is past the held frames)
+    for (;;) {
+        while (good_ + 1 < bad) {
+            size_t mid = good_ + (bad - good_) / 2;
+            if (fits(mid)) good_ = mid;
+            else bad = mid;
+        }
+        keep(good_);
+
+        // Redo the doubling over the frames already held after the new
+        // anchor; stop at the first span that misses, or wait for more
+        size_t last = window_.size() - 1;
+        good_ = std::min<size_t>(last, 1);
+        bad = 0;
+        for (size_t end = 2; end <= last; end *= 2) {
+            if (!fits(end)) {
+                bad = end;
+                break;
+            }
+            good_ = end;
+        }
+        if (bad == 0) return;
+    }
+}
+
+void ErrorBoundedFrameSink::drain()
+{
+    // Keep the last held frame, and whatever the span up to it needs
+    while (window_.size() > 1) {
+        size_t last = window_.size() - 1;
+        if (good_ < last && !fits(last)) resolve(last);
+        else keep(last);
+    }
+}
+
+// ============================================================================
+// AsyncFrameSink
+// ============================================================================
+
+AsyncFrameSink::AsyncFrameSink(FrameSink& next, size_t batch_frames, size_t max_batches)
+    : next_(next),
+      batch_frames_(batch_frames < 1 ? 1 : batch_frames),
+      max_batches_(max_batches < 1 ? 1 : max_batches),
+      writer_([this] { writer_loop(); })
+{
+    current_.reserve(batch_frames_);
+}
+
+AsyncFrameSink::~AsyncFrameSink()
+{
+    stop();
+}
+
+void AsyncFrameSink::push(const SimulationFrame& frame)
+{
+    current_.push_back(frame);
+    if (current_.size() >= batch_frames_) {
+        submit();
+    }
+}
+
+void AsyncFrameSink::submit()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (queue_.size() >= max_batches_) {
+            BH_TRACE_SCOPE("AsyncFrameSink stall");
+            stalls_++;
+            not_full_.wait(lock, [this] { return queue_.size() < max_batches_; });
+        }
+        queue_.push_back(std::move(current_));
+
+        current_.clear();
+        if (!spare_.empty()) {
+            current_ = std::move(spare_.back());
+            spare_.pop_back();
+        }
+    }
+    not_empty_.notify_one();
+    current_.reserve(batch_frames_);
+}
+
+void AsyncFrameSink::stop()
+{
+    if (!writer_.joinable()) return;
+
+    if (!current_.empty()) submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    not_empty_.notify_one();
+    writer_.join();
+}
+
+void AsyncFrameSink::finish(const SimulationResult& summary)
+{
+    stop();
+    next_.finish(summary);
+}
+
+void AsyncFrameSink::writer_loop()
+{
+    for (;;) {
+        std::vector<SimulationFrame> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this] { return closing_ || !queue_.empty(); });
+            if (queue_.empty()) return;     // Closing and drained
+            batch = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        not_full_.notify_one();
+
+        {
+            BH_TRACE_SCOPE("AsyncFrameSink batch");
+            for (const auto& f : batch) {
+                next_.push(f);
+            }
+        }
+
+        batch.clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        spare_.push_back(std::move(batch));
+    }
+}
+
+} // namespace bh
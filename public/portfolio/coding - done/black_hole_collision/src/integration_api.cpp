@@ -5,16 +5,69 @@
 
 #include "bh_collision/integration_api.h"
 #include "bh_collision/simulation.h"
+#include "bh_collision/frame_sink.h"
+#include "bh_collision/trace.h"
 #include <algorithm>
 #include <cmath>
 
 namespace bh {
 
+// ============================================================================
+// Per-frame conversion
+// ============================================================================
+
+CollisionRenderData CollisionRenderData::from_frame(const SimulationFrame& f) {
+    CollisionRenderData rd = {};
+    rd.time = (float)f.time;
+    rd.phase = f.phase;
+
+    // Determine number of active black holes
+    if (f.phase <= 1) {
+        rd.num_black_holes = 2;
+
+        // BH1
+        rd.black_holes[0].position = glm::vec3(f.bh1.position);
+        rd.black_holes[0].velocity = glm::vec3(f.bh1.velocity);
+        rd.black_holes[0].mass = (float)f.bh1.mass;
+        rd.black_holes[0].schwarzschild_radius = (float)f.bh1.schwarzschild_radius();
+        rd.black_holes[0].spin = (float)f.bh1.chi;
+        rd.black_holes[0].spin_axis = glm::vec3(f.bh1.spin_axis);
+        rd.black_holes[0].isco_radius = (float)f.bh1.isco_radius();
+
+        // BH2
+        rd.black_holes[1].position = glm::vec3(f.bh2.position);
+        rd.black_holes[1].velocity = glm::vec3(f.bh2.velocity);
+        rd.black_holes[1].mass = (float)f.bh2.mass;
+        rd.black_holes[1].schwarzschild_radius = (float)f.bh2.schwarzschild_radius();
+        rd.black_holes[1].spin = (float)f.bh2.chi;
+        rd.black_holes[1].spin_axis = glm::vec3(f.bh2.spin_axis);
+        rd.black_holes[1].isco_radius = (float)f.bh2.isco_radius();
+    } else {
+        rd.num_black_holes = 1;
+
+        rd.black_holes[0].position = glm::vec3(f.bh1.position);
+        rd.black_holes[0].velocity = glm::vec3(f.bh1.velocity);
+        rd.black_holes[0].mass = (float)f.bh1.mass;
+        rd.black_holes[0].schwarzschild_radius = (float)(2.0 * f.bh1.mass);
+        rd.black_holes[0].spin = (float)f.bh1.chi;
+        rd.black_holes[0].spin_axis = glm::vec3(0, 1, 0);
+        rd.black_holes[0].isco_radius = (float)f.bh1.isco_radius();
+    }
+
+    rd.gw_strain_plus = (float)f.gw.h_plus;
+    rd.gw_strain_cross = (float)f.gw.h_cross;
+    rd.gw_amplitude = (float)f.gw.amplitude;
+    rd.gw_frequency = (float)f.gw.frequency;
+    rd.orbital_phase = (float)f.orbital.orbital_phase;
+    return rd;
+}
+
 // ============================================================================
 // Build a render timeline from simulation results
 // ============================================================================
 
-CollisionTimeline CollisionTimeline::build(const SimulationResult& result) {
+CollisionTimeline CollisionTimeline::build(const SimulationResult& result, float max_position_error) {
+    BH_TRACE_SCOPE("CollisionTimeline::build");
     CollisionTimeline timeline;
 
     if (result.frames.empty()) {
@@ -28,55 +81,25 @@ CollisionTimeline CollisionTimeline::build(const SimulationResult& result) {
     timeline.total_duration = (float)result.frames.back().time;
     timeline.merger_frame_index = -1;
 
-    for (size_t i = 0; i < result.frames.size(); i++) {
-        const auto& f = result.frames[i];
-
-        CollisionRenderData rd = {};
-        rd.time = (float)f.time;
-        rd.phase = f.phase;
-
-        // Determine number of active black holes
-        if (f.phase <= 1) {
-            rd.num_black_holes = 2;
-
-            // BH1
-            rd.black_holes[0].position = glm::vec3(f.bh1.position);
-            rd.black_holes[0].mass = (float)f.bh1.mass;
-            rd.black_holes[0].schwarzschild_radius = (float)f.bh1.schwarzschild_radius();
-            rd.black_holes[0].spin = (float)f.bh1.chi;
-            rd.black_holes[0].spin_axis = glm::vec3(f.bh1.spin_axis);
-            rd.black_holes[0].isco_radius = (float)f.bh1.isco_radius();
-
-            // BH2
-            rd.black_holes[1].position = glm::vec3(f.bh2.position);
-            rd.black_holes[1].mass = (float)f.bh2.mass;
-            rd.black_holes[1].schwarzschild_radius = (float)f.bh2.schwarzschild_radius();
-            rd.black_holes[1].spin = (float)f.bh2.chi;
-            rd.black_holes[1].spin_axis = glm::vec3(f.bh2.spin_axis);
-            rd.black_holes[1].isco_radius = (float)f.bh2.isco_radius();
-
-            // Track merger frame
-            if (f.phase == 1 && timeline.merger_frame_index < 0) {
-                timeline.merger_frame_index = (int)i;
-            }
-        } else {
-            rd.num_black_holes = 1;
-
-            rd.black_holes[0].position = glm::vec3(f.bh1.position);
-            rd.black_holes[0].mass = (float)f.bh1.mass;
-            rd.black_holes[0].schwarzschild_radius = (float)(2.0 * f.bh1.mass);
-            rd.black_holes[0].spin = (float)f.bh1.chi;
-            rd.black_holes[0].spin_axis = glm::vec3(0, 1, 0);
-            rd.black_holes[0].isco_radius = (float)f.bh1.isco_radius();
+    CallbackFrameSink convert([&](const SimulationFrame& f) {
+        // Track merger frame
+        if (f.phase == 1 && timeline.merger_frame_index < 0) {
+            timeline.merger_frame_index = (int)timeline.frames.size();
         }
-
-        rd.gw_strain_plus = (float)f.gw.h_plus;
-        rd.gw_strain_cross = (float)f.gw.h_cross;
-        rd.gw_amplitude = (float)f.gw.amplitude;
-        rd.gw_frequency = (float)f.gw.frequency;
-        rd.orbital_phase = (float)f.orbital.orbital_phase;
-
-        timeline.frames.push_back(rd);
+        timeline.frames.push_back(CollisionRenderData::from_frame(f));
+    });
+
+    if (max_position_error > 0) {
+        DecimationTolerances tolerances;
+        tolerances.position = max_position_error;
+        tolerances.h_plus = tolerances.h_cross = 0;
+
+        ErrorBoundedFrameSink thin(convert, tolerances);
+        for (const auto& f : result.frames) thin.push(f);
+        thin.finish(result);
+    } else {
+        timeline.frames.reserve(result.frames.size());
+        for (const auto& f : result.frames) convert.push(f);
     }
 
     return timeline;
@@ -93,15 +116,37 @@ CollisionRenderData CollisionTimeline::interpolate(float t) const {
 
     // Clamp time
     t = std::max(0.0f, std::min(t, total_duration));
+    return interpolate_from(find_frame(t), t);
+}
 
-    // Binary search for the bounding frames
-    size_t lo = 0, hi = frames.size() - 1;
-    while (lo < hi - 1) {
-        size_t mid = (lo + hi) / 2;
+size_t CollisionTimeline::find_frame(float t) const {
+    size_t last = frames.size() < 2 ? 0 : frames.size() - 2;
+    size_t lo = 0, hi = last;
+
+    // Start from the time index bucket when there is one
+    if (!time_index.empty() && time_index_step > 0) {
+        size_t b = (size_t)std::max(0.0f, t / time_index_step);
+        b = std::min(b, time_index.size() - 1);
+        lo = time_index[b];
+        if (b + 1 < time_index.size()) hi = time_index[b + 1];
+
+        // Rounding in t / step can pick a neighbouring bucket
+        while (lo > 0 && frames[lo].time > t) lo--;
+        hi = std::max(hi, lo);
+        while (hi < last && frames[hi + 1].time <= t) hi++;
+    }
+
+    // Binary search for the last frame in [lo, hi] with time <= t
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
         if (frames[mid].time <= t) lo = mid;
-        else hi = mid;
+        else hi = mid - 1;
     }
+    return lo;
+}
 
+CollisionRenderData CollisionTimeline::interpolate_from(size_t lo, float t) const {
+    size_t hi = std::min(lo + 1, frames.size() - 1);
     if (lo == hi || t <= frames[lo].time) {
         return frames[lo];
     }
@@ -113,19 +158,56 @@ CollisionRenderData CollisionTimeline::interpolate(float t) const {
     float alpha = (t - frames[lo].time) / (frames[hi].time - frames[lo].time);
     alpha = std::max(0.0f, std::min(1.0f, alpha));
 
-    const auto& a = frames[lo];
-    const auto& b = frames[hi];
+    return CollisionRenderData::blend(frames[lo], frames[hi], t, alpha);
+}
+
+void CollisionTimeline::build_time_index(size_t buckets) {
+    time_index.clear();
+    time_index_step = 0;
+    if (frames.empty()) return;
+
+    if (buckets == 0) buckets = frames.size();
+    time_index_step = total_duration / (float)buckets;
+    if (!(time_index_step > 0)) return;
+
+    // One pass: the bracket only moves forward as the bucket time grows
+    size_t last = frames.size() < 2 ? 0 : frames.size() - 2;
+    size_t lo = 0;
+    time_index.resize(buckets);
+    for (size_t b = 0; b < buckets; b++) {
+        float t = (float)b * time_index_step;
+        while (lo < last && frames[lo + 1].time <= t) lo++;
+        time_index[b] = (uint32_t)lo;
+    }
+}
 
+CollisionRenderData CollisionRenderData::blend(const CollisionRenderData& a,
+                                               const CollisionRenderData& b,
+                                               float t, float alpha) {
     CollisionRenderData result = {};
     result.time = t;
     result.phase = (alpha < 0.5f) ? a.phase : b.phase;
     result.num_black_holes = (alpha < 0.5f) ? a.num_black_holes : b.num_black_holes;
 
+    // Positions follow the Hermite cubic while the same black holes are on
+    // both sides; across the merger they are mixed like everything else
+    float dt = b.time - a.time;
+    bool hermite = a.num_black_holes == b.num_black_holes && dt > 0;
+
     // Interpolate BH states
     int n = result.num_black_holes;
     for (int i = 0; i < n; i++) {
-        result.black_holes[i].position =
-            glm::mix(a.black_holes[i].position, b.black_holes[i].position, alpha);
+        const BHRenderState& bh_a = a.black_holes[i];
+        const BHRenderState& bh_b = b.black_holes[i];
+        if (hermite) {
+            result.black_holes[i].position = detail::hermite_position(
+                bh_a.position, bh_a.velocity, bh_b.position, bh_b.velocity, dt, alpha);
+            result.black_holes[i].velocity = detail::hermite_velocity(
+                bh_a.position, bh_a.velocity, bh_b.position, bh_b.velocity, dt, alpha);
+        } else {
+            result.black_holes[i].position = glm::mix(bh_a.position, bh_b.position, alpha);
+            result.black_holes[i].velocity = glm::mix(bh_a.velocity, bh_b.velocity, alpha);
+        }
         result.black_holes[i].mass =
             a.black_holes[i].mass * (1.0f - alpha) + b.black_holes[i].mass * alpha;
         result.black_holes[i].schwarzschild_radius =
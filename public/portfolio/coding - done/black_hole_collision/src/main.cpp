@@ -3,7 +3,7 @@
  * @brief CLI driver for the binary black hole collision simulation.
  *
  * Runs a complete inspiral → merger → ringdown simulation and outputs
- * results to stdout and a JSON file.
+ * results to stdout and a .bhrun (or JSON) file.
  *
  * Usage:
  *   bh_collision [options]
@@ -15,23 +15,52 @@
  *   --chi2 <spin>         Spin of BH2 [0,1) (default 0.0)
  *   --sep <separation>    Initial separation in M (default 20.0)
  *   --ecc <eccentricity>  Orbital eccentricity (default 0.0)
- *   --output <file>       Output JSON file (default output/simulation_data.json)
+ *   --output <file>       Output file (default output/simulation_data.bhrun);
+ *                         a .json extension writes JSON instead
+ *   --compact             Write JSON without indentation or line breaks
  *   --no-1pn              Disable 1PN corrections
  *   --no-2pn              Disable 2PN corrections
  *   --no-25pn             Disable 2.5PN radiation reaction
  *   --solar-mass <M_sun>  Total mass in solar masses (for SI conversion info)
+ *   --record <policy>     Inspiral frame times: time:<dt>, cycle:<n> (n per
+ *                         orbit) or gw:<df> (GW frequency steps); default
+ *                         every --record-interval, 4000x finer below 10 M
+ *   --integrator <name>   rk4 or dp54 (default dp54)
+ *   --tol <tolerance>     Local error tolerance for dp54 (default 1e-10)
+ *   --full-state          Integrate both bodies instead of the relative orbit
+ *   --fast-forward <a>    Orbit-average the inspiral down to separation a (M)
+ *   --handoff-v <v>       ...or until v/c reaches v, whichever comes first
+ *   --stream              Write frames to the output file as they are recorded
+ *   --decimate <n>        Keep every n-th inspiral frame
+ *   --max-error <d>       Keep only the inspiral frames needed to rebuild the
+ *                         rest within d (in M) of each black hole's position
+ *   --max-strain-error <h>  ...and within h of h+ and hx (default 1e-9)
+ *   --sweep <p>=<a>:<b>:<n>  Sweep parameter p (m1, m2, chi1, chi2, sep) over
+ *                         n values from a to b, or over a list <p>=<v1>,<v2>,...;
+ *                         repeat for a grid. Writes a CSV summary.
+ *   --threads <n>         Worker threads for --sweep and JSON export
+ *                         (default: all cores)
+ *   --trace <file>        Write a trace of the run's phases, export and
+ *                         writer threads (Chrome trace-event JSON)
  *   --help                Show this help
  */
 
 #include "bh_collision/simulation.h"
+#include "bh_collision/frame_sink.h"
+#include "bh_collision/run_file.h"
+#include "bh_collision/sweep.h"
 #include "bh_collision/integration_api.h"
 #include "bh_collision/black_hole.h"
+#include "bh_collision/trace.h"
 
 #include <cstdio>
 #include <cstring>
 #include <string>
 #include <cstdlib>
 #include <filesystem>
+#include <memory>
+#include <vector>
+#include <chrono>
 
 void print_help() {
     printf(
@@ -47,26 +76,243 @@ void print_help() {
         "  --chi2 <spin>         Spin of BH2 [0,1) (default 0.0)\n"
         "  --sep <distance>      Initial separation in M (default 20.0)\n"
         "  --ecc <eccentricity>  Orbital eccentricity (default 0.0)\n"
-        "  --output <file>       Output JSON file (default output/simulation_data.json)\n"
+        "  --output <file>       Output file (default output/simulation_data.bhrun)\n"
+        "                        A .json extension writes JSON (small runs only)\n"
+        "  --compact             Write JSON without indentation or line breaks\n"
         "  --no-1pn              Disable 1PN corrections\n"
         "  --no-2pn              Disable 2PN corrections\n"
         "  --no-25pn             Disable 2.5PN radiation reaction\n"
         "  --solar-mass <M>      Total mass in solar masses (for SI info)\n"
         "  --record-interval <t> Time between recorded frames (default 1.0 M)\n"
+        "  --record <policy>     Inspiral frame times instead: time:<dt>, cycle:<n>\n"
+        "                        (n per orbit) or gw:<df> (GW frequency steps)\n"
+        "  --integrator <name>   rk4 or dp54 (default dp54)\n"
+        "  --tol <tolerance>     Local error tolerance for dp54 (default 1e-10)\n"
+        "  --full-state          Integrate both bodies instead of the relative orbit\n"
+        "  --fast-forward <a>    Orbit-average the inspiral down to separation a (M)\n"
+        "  --handoff-v <v>       ...or until v/c reaches v, whichever comes first\n"
+        "  --stream              Write frames to the output file as they are recorded\n"
+        "                        (constant memory; skips the render timeline)\n"
+        "  --decimate <n>        Keep every n-th inspiral frame\n"
+        "  --max-error <d>       Keep only the inspiral frames needed to rebuild the\n"
+        "                        rest within d (in M) of each black hole's position\n"
+        "  --max-strain-error <h>\n"
+        "                        ...and within h of h+ and hx (default 1e-9)\n"
+        "  --sweep <p>=<a>:<b>:<n>\n"
+        "                        Sweep p (m1, m2, chi1, chi2, sep) over n values\n"
+        "                        from a to b, or over a list <p>=<v1>,<v2>,...\n"
+        "                        Repeat for a grid; writes a CSV summary\n"
+        "                        (default output/sweep.csv)\n"
+        "  --threads <n>         Worker threads for --sweep and JSON export\n"
+        "                        (default: all cores)\n"
+        "  --trace <file>        Write a trace of the run's phases, export and\n"
+        "                        writer threads (Chrome trace-event JSON, for\n"
+        "                        ui.perfetto.dev or chrome://tracing)\n"
         "  --help                Show this help\n\n"
         "Units:\n"
         "  All internal quantities use geometrized units (G = c = 1).\n"
         "  Mass is in units of total system mass M.\n"
         "  Distances in M, time in M.\n\n"
         "Example:\n"
-        "  bh_collision --m1 0.6 --m2 0.4 --sep 25 --chi1 0.3\n\n"
+        "  bh_collision --m1 0.6 --m2 0.4 --sep 25 --chi1 0.3\n"
+        "  bh_collision --sweep m1=0.5:0.8:4 --sweep sep=12,16,20\n\n"
     );
 }
 
+// ============================================================================
+// Recording policy
+// ============================================================================
+
+/// Parse time:<dt>, cycle:<n> or gw:<df>; null if the spec is invalid
+static std::shared_ptr<const bh::RecordingPolicy> parse_recording_policy(const char* spec) {
+    double value;
+    if (sscanf(spec, "time:%lf", &value) == 1 && value > 0) {
+        return std::make_shared<bh::UniformTimeRecording>(value);
+    }
+    if (sscanf(spec, "cycle:%lf", &value) == 1 && value >= 1) {
+        return std::make_shared<bh::PerCycleRecording>((int)value);
+    }
+    if (sscanf(spec, "gw:%lf", &value) == 1 && value > 0) {
+        return std::make_shared<bh::GWFrequencyRecording>(value);
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// Sweep mode
+// ============================================================================
+
+/// One swept parameter and its values
+struct SweepAxis {
+    std::string name;
+    std::vector<double> values;
+};
+
+/// Parse <name>=<start>:<stop>:<count> or <name>=<v1>,<v2>,...
+static bool parse_sweep_axis(const char* spec, SweepAxis& axis) {
+    const char* eq = strchr(spec, '=');
+    if (!eq) return false;
+
+    axis.name.assign(spec, eq - spec);
+    if (axis.name != "m1" && axis.name != "m2" && axis.name != "chi1" &&
+        axis.name != "chi2" && axis.name != "sep") {
+        return false;
+    }
+
+    const char* values = eq + 1;
+    if (strchr(values, ':')) {
+        double start, stop;
+        int count;
+        if (sscanf(values, "%lf:%lf:%d", &start, &stop, &count) != 3 || count < 1) {
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            double frac = (count > 1) ? (double)i / (count - 1) : 0.0;
+            axis.values.push_back(start + frac * (stop - start));
+        }
+    } else {
+        for (const char* p = values; *p; ) {
+            axis.values.push_back(atof(p));
+            p = strchr(p, ',');
+            if (!p) break;
+            p++;
+        }
+    }
+    return !axis.values.empty();
+}
+
+static void apply_sweep_value(bh::BinaryConfig& binary, const std::string& name, double value) {
+    if (name == "m1") binary.m1 = value;
+    else if (name == "m2") binary.m2 = value;
+    else if (name == "chi1") binary.chi1 = value;
+    else if (name == "chi2") binary.chi2 = value;
+    else if (name == "sep") binary.initial_separation = value;
+}
+
+/// Run the full grid spanned by the axes around the base configuration and
+/// write one CSV row per grid point
+static int run_sweep_mode(const bh::SimulationConfig& base,
+                          const std::vector<SweepAxis>& axes,
+                          unsigned num_threads,
+                          const std::string& csv_file) {
+    // Cartesian product, last axis varying fastest
+    size_t num_jobs = 1;
+    for (const auto& axis : axes) num_jobs *= axis.values.size();
+
+    std::vector<bh::SimulationConfig> configs;
+    configs.reserve(num_jobs);
+    for (size_t job = 0; job < num_jobs; job++) {
+        bh::SimulationConfig config = base;
+        config.progress_callback = nullptr;
+
+        size_t rest = job;
+        for (size_t a = axes.size(); a-- > 0; ) {
+            const SweepAxis& axis = axes[a];
+            apply_sweep_value(config.binary, axis.name, axis.values[rest % axis.values.size()]);
+            rest /= axis.values.size();
+        }
+
+        // Normalize masses so m1 + m2 = 1 at every grid point
+        double M_total = config.binary.m1 + config.binary.m2;
+        config.binary.m1 /= M_total;
+        config.binary.m2 /= M_total;
+        configs.push_back(config);
+    }
+
+    bh::WorkStealingExecutor executor(num_threads);
+    printf("  Sweep: %zu runs on %u threads\n\n", num_jobs, executor.concurrency());
+
+    auto start = std::chrono::steady_clock::now();
+    size_t finished = 0;
+    std::vector<bh::SimulationResult> results = bh::run_sweep(
+        configs, executor,
+        [&](size_t i, const bh::SimulationResult& r) {
+            finished++;
+            printf("  [%zu/%zu] #%zu  m1=%.3f m2=%.3f chi1=%.2f chi2=%.2f sep=%.1f  ",
+                   finished, num_jobs, i, r.config.m1, r.config.m2,
+                   r.config.chi1, r.config.chi2, r.config.initial_separation);
+            if (r.merger_occurred) {
+                printf("merger at %.1f M, %.1f GW cycles\n", r.merger_time, r.total_gw_cycles);
+            } else {
+                printf("no merger\n");
+            }
+            fflush(stdout);
+        }
+    );
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    printf("\n  Sweep complete in %.2f s\n", elapsed);
+
+    std::filesystem::path outpath(csv_file);
+    if (outpath.has_parent_path()) {
+        std::filesystem::create_directories(outpath.parent_path());
+    }
+    FILE* csv = fopen(csv_file.c_str(), "w");
+    if (!csv) {
+        printf("  ERROR: Failed to open %s\n", csv_file.c_str());
+        return 1;
+    }
+    fprintf(csv, "m1,m2,chi1,chi2,separation,merged,merger_time,gw_cycles,"
+                 "remnant_mass,remnant_spin,kick_velocity,qnm_frequency,qnm_damping_time\n");
+    for (const auto& r : results) {
+        fprintf(csv, "%.10g,%.10g,%.10g,%.10g,%.10g,%d,%.12g,%.12g,%.12g,%.12g,%.12g,%.12g,%.12g\n",
+                r.config.m1, r.config.m2, r.config.chi1, r.config.chi2,
+                r.config.initial_separation, r.merger_occurred ? 1 : 0,
+                r.merger_time, r.total_gw_cycles,
+                r.remnant.mass, r.remnant.spin, r.remnant.kick_velocity,
+                r.qnm.frequency, r.qnm.damping_time);
+    }
+    fclose(csv);
+    printf("  Summary written to: %s\n\n", csv_file.c_str());
+    return 0;
+}
+
+// ============================================================================
+// Tracing
+// ============================================================================
+
+/// With --trace, records spans until main() returns and writes them then,
+/// on every exit path. Declared first, so the sinks' threads have joined.
+struct TraceSession {
+    std::string filename;
+
+    void start(const std::string& file) {
+        filename = file;
+        bh::trace_start();
+    }
+
+    ~TraceSession() {
+        if (filename.empty()) return;
+        bh::trace_stop();
+        if (bh::write_trace(filename)) {
+            printf("  Trace written to: %s\n", filename.c_str());
+        } else {
+            printf("  ERROR: Failed to write %s\n", filename.c_str());
+        }
+    }
+};
+
 int main(int argc, char** argv) {
+    TraceSession trace;
     bh::SimulationConfig config;
-    std::string output_file = "output/simulation_data.json";
+    std::string output_file = "output/simulation_data.bhrun";
     double solar_masses = 60.0;  // default: 60 solar mass system (like GW150914)
+    bool output_given = false;
+    bool stream_output = false;
+    bh::ExportOptions json_options;
+    int decimate_every = 1;
+    bh::DecimationTolerances tolerances;
+    bool error_bounded = false;
+    std::vector<SweepAxis> sweep_axes;
+    unsigned num_threads = 0;
+
+    // Production default: error-controlled Dormand-Prince 5(4)
+    config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+    config.integrator.abs_tol = 1e-10;
+    config.integrator.rel_tol = 1e-10;
+
+    // Evolve only r = x1 - x2 and v = v1 - v2; bodies are rebuilt in the COM frame
+    config.integrator.relative_coordinates = true;
 
     // Parse command-line arguments
     for (int i = 1; i < argc; i++) {
@@ -94,6 +340,7 @@ int main(int argc, char** argv) {
         }
         else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
             output_file = argv[++i];
+            output_given = true;
         }
         else if (strcmp(argv[i], "--no-1pn") == 0) {
             config.enable_1pn = false;
@@ -110,6 +357,70 @@ int main(int argc, char** argv) {
         else if (strcmp(argv[i], "--record-interval") == 0 && i + 1 < argc) {
             config.record_interval = atof(argv[++i]);
         }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            config.recording = parse_recording_policy(argv[++i]);
+            if (!config.recording) {
+                printf("Invalid recording policy: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--integrator") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "rk4") == 0) {
+                config.integrator.method = bh::IntegratorMethod::RK4;
+            } else if (strcmp(name, "dp54") == 0) {
+                config.integrator.method = bh::IntegratorMethod::DormandPrince54;
+            } else {
+                printf("Unknown integrator: %s\n", name);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--tol") == 0 && i + 1 < argc) {
+            config.integrator.abs_tol = atof(argv[++i]);
+            config.integrator.rel_tol = config.integrator.abs_tol;
+        }
+        else if (strcmp(argv[i], "--full-state") == 0) {
+            config.integrator.relative_coordinates = false;
+        }
+        else if (strcmp(argv[i], "--fast-forward") == 0 && i + 1 < argc) {
+            config.secular.enabled = true;
+            config.secular.handoff_separation = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--handoff-v") == 0 && i + 1 < argc) {
+            config.secular.enabled = true;
+            config.secular.handoff_velocity = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--compact") == 0) {
+            json_options.compact = true;
+        }
+        else if (strcmp(argv[i], "--stream") == 0) {
+            stream_output = true;
+        }
+        else if (strcmp(argv[i], "--decimate") == 0 && i + 1 < argc) {
+            decimate_every = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-error") == 0 && i + 1 < argc) {
+            tolerances.position = atof(argv[++i]);
+            error_bounded = true;
+        }
+        else if (strcmp(argv[i], "--max-strain-error") == 0 && i + 1 < argc) {
+            tolerances.h_plus = tolerances.h_cross = atof(argv[++i]);
+            error_bounded = true;
+        }
+        else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            SweepAxis axis;
+            if (!parse_sweep_axis(argv[++i], axis)) {
+                printf("Invalid sweep: %s\n", argv[i]);
+                return 1;
+            }
+            sweep_axes.push_back(axis);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = (unsigned)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace.start(argv[++i]);
+        }
         else {
             printf("Unknown option: %s\n", argv[i]);
             print_help();
@@ -122,10 +433,17 @@ int main(int argc, char** argv) {
     config.binary.m1 /= M_total;
     config.binary.m2 /= M_total;
 
-    // MAXIMUM Fidelity Settings (100x more detailed)
-    config.integrator.safety_factor = 0.000001; // Extremely conservative steps
-    config.integrator.dt_min = 1e-10;           // Sub-nanosecond resolution
-    config.integrator.dt_max = 0.1;
+    if (config.integrator.method == bh::IntegratorMethod::RK4) {
+        // MAXIMUM Fidelity Settings (100x more detailed)
+        config.integrator.safety_factor = 0.000001; // Extremely conservative steps
+        config.integrator.dt_min = 1e-10;           // Sub-nanosecond resolution
+        config.integrator.dt_max = 0.1;
+    } else {
+        // Step size is set by the error estimate. Frames are interpolated
+        // from the dense output, so dt_max is only a loose cap.
+        config.integrator.dt_min = 1e-10;
+        config.integrator.dt_max = 10.0;
+    }
 
     config.binary.distance = 1e6;
     config.binary.inclination = 0.0;
@@ -134,6 +452,11 @@ int main(int argc, char** argv) {
     config.observer_distance = config.binary.distance;
     config.observer_inclination = config.binary.inclination;
 
+    if (!sweep_axes.empty()) {
+        return run_sweep_mode(config, sweep_axes, num_threads,
+                              output_given ? output_file : "output/sweep.csv");
+    }
+
     // Print header
     printf("\n");
     printf("================================================================\n");
@@ -166,26 +489,105 @@ int main(int argc, char** argv) {
         fflush(stdout);
     };
 
+    // Create output directory if needed
+    std::filesystem::path outpath(output_file);
+    if (outpath.has_parent_path()) {
+        std::filesystem::create_directories(outpath.parent_path());
+    }
+    bool json_output = outpath.extension() == ".json";
+
+    // A .bhrun file (and with --stream any output) is written while the
+    // simulation runs, by a background writer fed through a bounded queue.
+    // Frames are also kept in memory for the timeline unless streaming;
+    // JSON without --stream is exported from memory afterwards.
+    bool write_during_run = stream_output || !json_output;
+    bh::VectorFrameSink memory_sink;
+    std::unique_ptr<bh::FrameSink> file_sink;
+    bh::RunFileSink* run_sink = nullptr;
+    bh::JsonFrameSink* json_stream = nullptr;
+    if (write_during_run) {
+        bool opened;
+        if (json_output) {
+            auto json_sink = std::make_unique<bh::JsonFrameSink>(output_file, json_options);
+            opened = json_sink->is_open();
+            json_stream = json_sink.get();
+            file_sink = std::move(json_sink);
+        } else {
+            auto bhrun_sink = std::make_unique<bh::RunFileSink>(output_file);
+            opened = bhrun_sink->is_open();
+            run_sink = bhrun_sink.get();
+            file_sink = std::move(bhrun_sink);
+        }
+        if (!opened) {
+            printf("  ERROR: Failed to open %s\n", output_file.c_str());
+            return 1;
+        }
+    }
+
+    std::unique_ptr<bh::AsyncFrameSink> writer;
+    std::unique_ptr<bh::TeeFrameSink> tee;
+    bh::FrameSink* sink = &memory_sink;
+    if (write_during_run) {
+        writer = std::make_unique<bh::AsyncFrameSink>(*file_sink);
+        sink = writer.get();
+        if (!stream_output) {
+            tee = std::make_unique<bh::TeeFrameSink>(memory_sink, *writer);
+            sink = tee.get();
+        }
+    }
+
+    std::unique_ptr<bh::DecimatingFrameSink> decimator;
+    if (decimate_every > 1) {
+        decimator = std::make_unique<bh::DecimatingFrameSink>(*sink, decimate_every);
+        sink = decimator.get();
+    }
+
+    std::unique_ptr<bh::ErrorBoundedFrameSink> thinner;
+    if (error_bounded) {
+        thinner = std::make_unique<bh::ErrorBoundedFrameSink>(*sink, tolerances);
+        sink = thinner.get();
+    }
+
     // Run simulation
     printf("  Running simulation...\n");
-    bh::SimulationResult result = bh::run_simulation(config);
+    bh::SimulationResult result = bh::run_simulation(config, *sink);
+    result.frames = std::move(memory_sink.frames);
     printf("\r  Simulation complete!                              \n");
 
     // Print results
     bh::print_summary(result);
 
-    // Export to JSON
-    // Create output directory if needed
-    std::filesystem::path outpath(output_file);
-    if (outpath.has_parent_path()) {
-        std::filesystem::create_directories(outpath.parent_path());
+    if (thinner) {
+        const auto& kept = thinner->source_indices();
+        printf("  Error-bounded decimation kept %zu of %llu frames\n", kept.size(),
+               kept.empty() ? 0ULL : (unsigned long long)kept.back() + 1);
     }
 
-    if (bh::export_to_json(result, output_file)) {
+    if (stream_output) {
+        if (!(run_sink ? run_sink->complete() : json_stream->complete())) {
+            printf("  ERROR: Failed to write %s\n", output_file.c_str());
+            return 1;
+        }
+        printf("  Data streamed to: %s\n", output_file.c_str());
+        printf("\n");
+        return 0;
+    }
+
+    bool exported;
+    if (write_during_run) {
+        exported = run_sink->complete();
+    } else {
+        // Export, formatting chunks of frames on the worker threads
+        bh::WorkStealingExecutor export_executor(num_threads);
+        json_options.executor = &export_executor;
+        exported = bh::export_to_json(result, output_file, json_options);
+    }
+    if (exported) {
         printf("  Data exported to: %s\n", output_file.c_str());
         printf("  Total frames: %zu\n", result.frames.size());
     } else {
         printf("  ERROR: Failed to export to %s\n", output_file.c_str());
+        return 1;
     }
 
     // Build render timeline (demonstrates integration API)
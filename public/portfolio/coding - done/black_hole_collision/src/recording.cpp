@@ -0,0 +1,51 @@
+/**
+ * @file recording.cpp
+ * @brief Stock recording policies.
+ */
+
+#include "bh_collision/recording.h"
+#include "bh_collision/simulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bh {
+
+double UniformTimeRecording::next_time(const SimulationFrame& frame) const
+{
+    return frame.time + interval_;
+}
+
+double PlungeRefinedRecording::next_time(const SimulationFrame& frame) const
+{
+    const OrbitalParams& orb = frame.orbital;
+    if (orb.separation < refine_separation_ * orb.total_mass) {
+        return frame.time + interval_ / refine_factor_;
+    }
+    return frame.time + interval_;
+}
+
+double PerCycleRecording::next_time(const SimulationFrame& frame) const
+{
+    double omega = frame.orbital.orbital_frequency;
+    double dt = max_interval_;
+    if (omega > 0) {
+        dt = std::min(dt, 2.0 * M_PI / (omega * samples_));
+    }
+    return frame.time + dt;
+}
+
+double GWFrequencyRecording::next_time(const SimulationFrame& frame) const
+{
+    double f = frame.gw.frequency;
+    double mc = frame.orbital.chirp_mass;
+    double dt = max_interval_;
+    if (f > 0 && mc > 0) {
+        double dfdt = 96.0 / 5.0 * std::pow(M_PI, 8.0 / 3.0) *
+                      std::pow(mc, 5.0 / 3.0) * std::pow(f, 11.0 / 3.0);
+        dt = std::min(dt, delta_f_ / dfdt);
+    }
+    return frame.time + dt;
+}
+
+} // namespace bh
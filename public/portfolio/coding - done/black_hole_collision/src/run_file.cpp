@@ -0,0 +1,545 @@
+/**
+ * @file run_file.cpp
+ * @brief .bhrun writer and reader.
+ */
+
+#include "bh_collision/run_file.h"
+#include "bh_collision/sweep.h"
+#include "bh_collision/trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bh {
+
+static const unsigned char RUN_FILE_MAGIC[8] = { 'B', 'H', 'R', 'U', 'N', '\r', '\n', 0x1A };
+
+// ============================================================================
+// Column mapping
+// ============================================================================
+
+/// The FrameColumns array stored as column c. Phase is kept as int in
+/// FrameColumns and has no double array, so it maps to nullptr.
+static std::vector<double>* column_of(FrameColumns& f, RunColumn c)
+{
+    switch (c) {
+        case RunColumn::time:                 return &f.time;
+        case RunColumn::phase:                return nullptr;
+        case RunColumn::bh1_mass:             return &f.bh1.mass;
+        case RunColumn::bh1_chi:              return &f.bh1.chi;
+        case RunColumn::bh1_x:                return &f.bh1.position.x;
+        case RunColumn::bh1_y:                return &f.bh1.position.y;
+        case RunColumn::bh1_z:                return &f.bh1.position.z;
+        case RunColumn::bh1_vx:               return &f.bh1.velocity.x;
+        case RunColumn::bh1_vy:               return &f.bh1.velocity.y;
+        case RunColumn::bh1_vz:               return &f.bh1.velocity.z;
+        case RunColumn::bh1_spin_x:           return &f.bh1.spin_axis.x;
+        case RunColumn::bh1_spin_y:           return &f.bh1.spin_axis.y;
+        case RunColumn::bh1_spin_z:           return &f.bh1.spin_axis.z;
+        case RunColumn::bh2_mass:             return &f.bh2.mass;
+        case RunColumn::bh2_chi:              return &f.bh2.chi;
+        case RunColumn::bh2_x:                return &f.bh2.position.x;
+        case RunColumn::bh2_y:                return &f.bh2.position.y;
+        case RunColumn::bh2_z:                return &f.bh2.position.z;
+        case RunColumn::bh2_vx:               return &f.bh2.velocity.x;
+        case RunColumn::bh2_vy:               return &f.bh2.velocity.y;
+        case RunColumn::bh2_vz:               return &f.bh2.velocity.z;
+        case RunColumn::bh2_spin_x:           return &f.bh2.spin_axis.x;
+        case RunColumn::bh2_spin_y:           return &f.bh2.spin_axis.y;
+        case RunColumn::bh2_spin_z:           return &f.bh2.spin_axis.z;
+        case RunColumn::separation:           return &f.separation;
+        case RunColumn::orbital_frequency:    return &f.orbital_frequency;
+        case RunColumn::orbital_phase:        return &f.orbital_phase;
+        case RunColumn::radial_velocity:      return &f.radial_velocity;
+        case RunColumn::velocity_param:       return &f.velocity_param;
+        case RunColumn::reduced_mass:         return &f.reduced_mass;
+        case RunColumn::total_mass:           return &f.total_mass;
+        case RunColumn::symmetric_mass_ratio: return &f.symmetric_mass_ratio;
+        case RunColumn::chirp_mass:           return &f.chirp_mass;
+        case RunColumn::energy:               return &f.energy;
+        case RunColumn::angular_momentum:     return &f.angular_momentum;
+        case RunColumn::h_plus:               return &f.h_plus;
+        case RunColumn::h_cross:              return &f.h_cross;
+        case RunColumn::gw_amplitude:         return &f.gw_amplitude;
+        case RunColumn::gw_frequency:         return &f.gw_frequency;
+        case RunColumn::count:                break;
+    }
+    return nullptr;
+}
+
+static const std::vector<double>* column_of(const FrameColumns& f, RunColumn c)
+{
+    return column_of(const_cast<FrameColumns&>(f), c);
+}
+
+// ============================================================================
+// Header encoding (host is little-endian, so values are copied as they are)
+// ============================================================================
+
+struct ByteWriter {
+    unsigned char* data;
+    size_t pos = 0;
+
+    void u32(uint32_t v) { std::memcpy(data + pos, &v, 4); pos += 4; }
+    void u64(uint64_t v) { std::memcpy(data + pos, &v, 8); pos += 8; }
+    void f64(double v)   { std::memcpy(data + pos, &v, 8); pos += 8; }
+    void vec3(const glm::dvec3& v) { f64(v.x); f64(v.y); f64(v.z); }
+};
+
+struct ByteReader {
+    const unsigned char* data;
+    size_t pos = 0;
+
+    uint32_t u32() { uint32_t v; std::memcpy(&v, data + pos, 4); pos += 4; return v; }
+    uint64_t u64() { uint64_t v; std::memcpy(&v, data + pos, 8); pos += 8; return v; }
+    double f64()   { double v;   std::memcpy(&v, data + pos, 8); pos += 8; return v; }
+    glm::dvec3 vec3() { glm::dvec3 v; v.x = f64(); v.y = f64(); v.z = f64(); return v; }
+};
+
+/// Header bytes for a finished file. Works on SimulationResult and
+/// ColumnarResult, which share the summary fields.
+template <typename Result>
+static void encode_header(const RunFileLayout& layout, const Result& r,
+                          unsigned char (&bytes)[RUN_FILE_HEADER_BYTES])
+{
+    std::memset(bytes, 0, RUN_FILE_HEADER_BYTES);
+    std::memcpy(bytes, RUN_FILE_MAGIC, 8);
+
+    ByteWriter w{ bytes, 8 };
+    w.u32(RUN_FILE_VERSION);
+    w.u32((uint32_t)RUN_FILE_HEADER_BYTES);
+    w.u64(RUN_FILE_NUM_COLUMNS);
+    w.u64(layout.num_frames);
+    w.u64(layout.chunk_frames);
+    w.u64(layout.chunks.size());
+    w.u64(layout.index_offset);
+    w.u64(r.merger_occurred ? 1 : 0);
+    w.u64((uint64_t)r.num_inspiral_frames);
+    w.u64((uint64_t)r.num_ringdown_frames);
+
+    // Config
+    w.f64(r.config.m1);
+    w.f64(r.config.m2);
+    w.f64(r.config.chi1);
+    w.f64(r.config.chi2);
+    w.vec3(r.config.spin_axis1);
+    w.vec3(r.config.spin_axis2);
+    w.f64(r.config.initial_separation);
+    w.f64(r.config.eccentricity);
+    w.f64(r.config.inclination);
+    w.f64(r.config.distance);
+
+    // Run
+    w.f64(r.merger_time);
+    w.f64(r.total_gw_cycles);
+    w.f64(r.total_energy_radiated);
+
+    // Remnant
+    w.f64(r.remnant.mass);
+    w.f64(r.remnant.spin);
+    w.vec3(r.remnant.position);
+    w.vec3(r.remnant.velocity);
+    w.f64(r.remnant.kick_velocity);
+    w.f64(r.remnant.energy_radiated);
+
+    // QNM
+    w.f64(r.qnm.frequency);
+    w.f64(r.qnm.damping_time);
+    w.f64(r.qnm.amplitude);
+    w.f64(r.qnm.phase);
+}
+
+namespace detail {
+
+bool host_is_little_endian()
+{
+    uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+bool parse_run_header(const unsigned char* data, size_t size, uint64_t file_size,
+                      RunFileLayout& layout, ColumnarResult& r, std::string& error)
+{
+    if (size < RUN_FILE_HEADER_BYTES || std::memcmp(data, RUN_FILE_MAGIC, 8) != 0) {
+        error = "not a .bhrun file";
+        return false;
+    }
+
+    ByteReader in{ data, 8 };
+    layout.version = in.u32();
+    if (layout.version != RUN_FILE_VERSION) {
+        error = "unsupported .bhrun version " + std::to_string(layout.version);
+        return false;
+    }
+    uint32_t header_bytes = in.u32();
+    uint64_t num_columns = in.u64();
+    if (header_bytes != RUN_FILE_HEADER_BYTES || num_columns != RUN_FILE_NUM_COLUMNS) {
+        error = "corrupt .bhrun header";
+        return false;
+    }
+
+    layout.num_frames = in.u64();
+    layout.chunk_frames = in.u64();
+    uint64_t num_chunks = in.u64();
+    layout.index_offset = in.u64();
+    if (layout.index_offset == 0) {
+        error = "incomplete .bhrun file (run did not finish)";
+        return false;
+    }
+    if (layout.index_offset < RUN_FILE_HEADER_BYTES || layout.index_offset > file_size ||
+        num_chunks > (file_size - layout.index_offset) / 24) {
+        error = "truncated .bhrun file";
+        return false;
+    }
+    layout.chunks.assign((size_t)num_chunks, RunChunk{});
+
+    r = {};
+    r.merger_occurred = in.u64() != 0;
+    r.num_inspiral_frames = (int)in.u64();
+    r.num_ringdown_frames = (int)in.u64();
+
+    r.config.m1 = in.f64();
+    r.config.m2 = in.f64();
+    r.config.chi1 = in.f64();
+    r.config.chi2 = in.f64();
+    r.config.spin_axis1 = in.vec3();
+    r.config.spin_axis2 = in.vec3();
+    r.config.initial_separation = in.f64();
+    r.config.eccentricity = in.f64();
+    r.config.inclination = in.f64();
+    r.config.distance = in.f64();
+
+    r.merger_time = in.f64();
+    r.total_gw_cycles = in.f64();
+    r.total_energy_radiated = in.f64();
+
+    r.remnant.mass = in.f64();
+    r.remnant.spin = in.f64();
+    r.remnant.position = in.vec3();
+    r.remnant.velocity = in.vec3();
+    r.remnant.kick_velocity = in.f64();
+    r.remnant.energy_radiated = in.f64();
+
+    r.qnm.frequency = in.f64();
+    r.qnm.damping_time = in.f64();
+    r.qnm.amplitude = in.f64();
+    r.qnm.phase = in.f64();
+    return true;
+}
+
+bool parse_run_index(const unsigned char* data, size_t size,
+                     RunFileLayout& layout, std::string& error)
+{
+    if (size / 24 < layout.chunks.size()) {
+        error = "truncated .bhrun chunk index";
+        return false;
+    }
+
+    // Written so that no sum or product can wrap around
+    const uint64_t frame_bytes = RUN_FILE_NUM_COLUMNS * sizeof(double);
+    ByteReader in{ data, 0 };
+    uint64_t next_frame = 0;
+    uint64_t prev_end = RUN_FILE_HEADER_BYTES;
+    for (RunChunk& chunk : layout.chunks) {
+        chunk.offset = in.u64();
+        chunk.first_frame = in.u64();
+        chunk.num_frames = in.u64();
+
+        if (chunk.first_frame != next_frame || chunk.offset < prev_end ||
+            chunk.offset % 8 != 0 || chunk.offset > layout.index_offset ||
+            chunk.num_frames > (layout.index_offset - chunk.offset) / frame_bytes ||
+            chunk.num_frames > layout.num_frames - next_frame) {
+            error = "corrupt .bhrun chunk index";
+            return false;
+        }
+        prev_end = chunk.offset + chunk.num_frames * frame_bytes;
+        next_frame += chunk.num_frames;
+    }
+
+    if (next_frame != layout.num_frames) {
+        error = "corrupt .bhrun chunk index";
+        return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+static bool begin_run_file(std::ofstream& out, const std::string& filename)
+{
+    if (!detail::host_is_little_endian()) return false;
+
+    out.open(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+
+    // Placeholder; the real header is written once the counts are known
+    unsigned char zeros[RUN_FILE_HEADER_BYTES] = {};
+    out.write(reinterpret_cast<const char*>(zeros), RUN_FILE_HEADER_BYTES);
+    return true;
+}
+
+/// Append frames [begin, begin + n) of cols as one chunk
+static void write_run_chunk(std::ofstream& out, RunFileLayout& layout,
+                            const FrameColumns& cols, size_t begin, size_t n)
+{
+    if (n == 0) return;
+
+    // Start every chunk on a 64-byte boundary
+    uint64_t offset = (uint64_t)out.tellp();
+    static const char padding[64] = {};
+    if (offset % 64 != 0) {
+        out.write(padding, 64 - offset % 64);
+        offset += 64 - offset % 64;
+    }
+
+    std::vector<double> phase;
+    for (size_t c = 0; c < RUN_FILE_NUM_COLUMNS; c++) {
+        const double* data;
+        if (c == (size_t)RunColumn::phase) {
+            phase.assign(cols.phase.begin() + begin, cols.phase.begin() + begin + n);
+            data = phase.data();
+        } else {
+            data = column_of(cols, (RunColumn)c)->data() + begin;
+        }
+        out.write(reinterpret_cast<const char*>(data), n * sizeof(double));
+    }
+
+    layout.chunks.push_back(RunChunk{ offset, layout.num_frames, n });
+    layout.num_frames += n;
+}
+
+/// Write the chunk index and the final header, then close
+template <typename Result>
+static bool end_run_file(std::ofstream& out, RunFileLayout& layout, const Result& summary)
+{
+    layout.index_offset = (uint64_t)out.tellp();
+    for (const RunChunk& chunk : layout.chunks) {
+        uint64_t entry[3] = { chunk.offset, chunk.first_frame, chunk.num_frames };
+        out.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+    }
+
+    unsigned char header[RUN_FILE_HEADER_BYTES];
+    encode_header(layout, summary, header);
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(header), RUN_FILE_HEADER_BYTES);
+
+    bool ok = out.good();
+    out.close();
+    return ok;
+}
+
+RunFileSink::RunFileSink(const std::string& filename, size_t chunk_frames)
+    : chunk_frames_(chunk_frames < 1 ? 1 : chunk_frames)
+{
+    layout_.version = RUN_FILE_VERSION;
+    layout_.chunk_frames = chunk_frames_;
+    if (begin_run_file(out_, filename)) {
+        pending_.reserve(chunk_frames_);
+    }
+}
+
+void RunFileSink::push(const SimulationFrame& frame)
+{
+    if (!out_.is_open()) return;
+
+    pending_.push_back(frame);
+    if (pending_.size() >= chunk_frames_) {
+        flush_chunk();
+    }
+}
+
+void RunFileSink::flush_chunk()
+{
+    BH_TRACE_SCOPE("RunFileSink::flush_chunk");
+    write_run_chunk(out_, layout_, pending_, 0, pending_.size());
+    pending_.clear();
+}
+
+void RunFileSink::finish(const SimulationResult& summary)
+{
+    if (!out_.is_open()) return;
+
+    flush_chunk();
+    complete_ = end_run_file(out_, layout_, summary);
+}
+
+bool write_run(const std::string& filename, const SimulationResult& result,
+               size_t chunk_frames, Executor* executor)
+{
+    BH_TRACE_SCOPE("write_run");
+    if (!executor || executor->concurrency() <= 1) {
+        RunFileSink sink(filename, chunk_frames);
+        if (!sink.is_open()) return false;
+
+        for (const auto& f : result.frames) {
+            sink.push(f);
+        }
+        sink.finish(result);
+        return sink.complete();
+    }
+
+    std::ofstream out;
+    if (!begin_run_file(out, filename)) return false;
+    if (chunk_frames < 1) chunk_frames = 1;
+
+    RunFileLayout layout = {};
+    layout.version = RUN_FILE_VERSION;
+    layout.chunk_frames = chunk_frames;
+
+    // A few chunks per thread at a time, written in file order
+    size_t total = result.frames.size();
+    size_t num_chunks = (total + chunk_frames - 1) / chunk_frames;
+    size_t batch = 2 * (size_t)executor->concurrency();
+    std::vector<FrameColumns> columns(batch);
+
+    for (size_t first = 0; first < num_chunks; first += batch) {
+        size_t count = std::min(batch, num_chunks - first);
+
+        executor->parallel_for(count, [&](size_t k) {
+            size_t begin = (first + k) * chunk_frames;
+            size_t end = std::min(total, begin + chunk_frames);
+            columns[k].clear();
+            columns[k].reserve(chunk_frames);
+            for (size_t i = begin; i < end; i++) {
+                columns[k].push_back(result.frames[i]);
+            }
+        });
+
+        for (size_t k = 0; k < count; k++) {
+            write_run_chunk(out, layout, columns[k], 0, columns[k].size());
+        }
+    }
+    return end_run_file(out, layout, result);
+}
+
+bool write_run(const std::string& filename, const ColumnarResult& result, size_t chunk_frames)
+{
+    std::ofstream out;
+    if (!begin_run_file(out, filename)) return false;
+    if (chunk_frames < 1) chunk_frames = 1;
+
+    RunFileLayout layout = {};
+    layout.version = RUN_FILE_VERSION;
+    layout.chunk_frames = chunk_frames;
+
+    size_t total = result.frames.size();
+    for (size_t begin = 0; begin < total; begin += chunk_frames) {
+        write_run_chunk(out, layout, result.frames, begin, std::min(chunk_frames, total - begin));
+    }
+    return end_run_file(out, layout, result);
+}
+
+// ============================================================================
+// Reading
+// ============================================================================
+
+bool RunFileReader::open(const std::string& filename)
+{
+    if (!detail::host_is_little_endian()) {
+        error_ = ".bhrun files need a little-endian host";
+        return false;
+    }
+
+    in_.open(filename, std::ios::binary);
+    if (!in_.is_open()) {
+        error_ = "cannot open " + filename;
+        return false;
+    }
+
+    in_.seekg(0, std::ios::end);
+    uint64_t file_size = (uint64_t)in_.tellg();
+    in_.seekg(0);
+
+    unsigned char header[RUN_FILE_HEADER_BYTES];
+    in_.read(reinterpret_cast<char*>(header), RUN_FILE_HEADER_BYTES);
+    size_t got = (size_t)in_.gcount();
+    if (!detail::parse_run_header(header, got, file_size, layout_, summary_, error_)) {
+        return false;
+    }
+
+    std::vector<unsigned char> index(layout_.chunks.size() * 24);
+    in_.seekg((std::streamoff)layout_.index_offset);
+    in_.read(reinterpret_cast<char*>(index.data()), (std::streamsize)index.size());
+    return detail::parse_run_index(index.data(), (size_t)in_.gcount(), layout_, error_);
+}
+
+bool RunFileReader::read_chunk(size_t i, FrameColumns& out)
+{
+    if (i >= layout_.chunks.size()) {
+        error_ = "chunk index out of range";
+        return false;
+    }
+
+    // open() checked that the chunk lies inside the file, so the buffer is
+    // never larger than the file
+    const RunChunk& chunk = layout_.chunks[i];
+    size_t n = (size_t)chunk.num_frames;
+    buffer_.resize(n * RUN_FILE_NUM_COLUMNS);
+
+    in_.clear();
+    in_.seekg((std::streamoff)chunk.offset);
+    in_.read(reinterpret_cast<char*>(buffer_.data()),
+             (std::streamsize)(buffer_.size() * sizeof(double)));
+    if ((size_t)in_.gcount() != buffer_.size() * sizeof(double)) {
+        error_ = "truncated .bhrun chunk";
+        return false;
+    }
+
+    // Phases are small integers; anything else (NaN included) would make
+    // the int conversion undefined, so the chunk is rejected before use
+    const double* phases = buffer_.data() + (size_t)RunColumn::phase * n;
+    for (size_t k = 0; k < n; k++) {
+        if (!(phases[k] >= 0.0 && phases[k] <= 3.0)) {
+            error_ = "corrupt .bhrun phase column";
+            return false;
+        }
+    }
+
+    for (size_t c = 0; c < RUN_FILE_NUM_COLUMNS; c++) {
+        const double* data = buffer_.data() + c * n;
+        if (c == (size_t)RunColumn::phase) {
+            for (size_t k = 0; k < n; k++) out.phase.push_back((int)data[k]);
+        } else {
+            column_of(out, (RunColumn)c)->insert(
+                column_of(out, (RunColumn)c)->end(), data, data + n);
+        }
+    }
+    return true;
+}
+
+bool read_run(const std::string& filename, ColumnarResult& result, std::string* error)
+{
+    RunFileReader reader;
+    if (!reader.open(filename)) {
+        if (error) *error = reader.error();
+        return false;
+    }
+
+    // Bounded by the file size once open() has validated the index
+    result = reader.summary();
+    result.frames.reserve((size_t)reader.layout().num_frames);
+    for (size_t i = 0; i < reader.layout().chunks.size(); i++) {
+        if (!reader.read_chunk(i, result.frames)) {
+            if (error) *error = reader.error();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool read_run(const std::string& filename, SimulationResult& result, std::string* error)
+{
+    ColumnarResult columnar;
+    if (!read_run(filename, columnar, error)) return false;
+
+    result = to_result(columnar);
+    return true;
+}
+
+} // namespace bh
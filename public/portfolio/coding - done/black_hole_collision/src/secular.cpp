@@ -0,0 +1,169 @@
+/**
+ * @file secular.cpp
+ * @brief Orbit-averaged Peters-Mathews evolution and Keplerian conversions.
+ */
+
+#include "bh_collision/secular.h"
+
+#include <cmath>
+
+namespace bh {
+
+// ============================================================================
+// Peters (1964) orbit-averaged rates
+// ============================================================================
+
+SecularRates secular_rates(const SecularState& s, double eta, double total_mass)
+{
+    double M = total_mass;
+    double a = s.a;
+    double e2 = s.e * s.e;
+    double one_minus_e2 = 1.0 - e2;
+
+    // beta = (64/5) m1 m2 (m1 + m2) = (64/5) eta M^3
+    double beta = 64.0 / 5.0 * eta * M * M * M;
+
+    SecularRates r;
+
+    // da/dt = -beta / (a^3 (1-e^2)^(7/2)) * (1 + 73/24 e^2 + 37/96 e^4)
+    r.da = -beta / (a * a * a * std::pow(one_minus_e2, 3.5)) *
+           (1.0 + 73.0 / 24.0 * e2 + 37.0 / 96.0 * e2 * e2);
+
+    // de/dt = -(19/12) beta e / (a^4 (1-e^2)^(5/2)) * (1 + 121/304 e^2)
+    r.de = -19.0 / 12.0 * beta * s.e / (a * a * a * a * std::pow(one_minus_e2, 2.5)) *
+           (1.0 + 121.0 / 304.0 * e2);
+
+    // Mean motion n = sqrt(M / a^3)
+    r.dphase = std::sqrt(M / (a * a * a));
+
+    return r;
+}
+
+static SecularState secular_add(const SecularState& s, const SecularRates& r, double dt)
+{
+    SecularState out = s;
+    out.a = s.a + r.da * dt;
+    out.e = s.e + r.de * dt;
+    out.phase = s.phase + r.dphase * dt;
+    out.time = s.time + dt;
+    return out;
+}
+
+SecularState secular_step(const SecularState& s, double dt, double eta, double total_mass)
+{
+    SecularRates k1 = secular_rates(s, eta, total_mass);
+    SecularRates k2 = secular_rates(secular_add(s, k1, dt * 0.5), eta, total_mass);
+    SecularRates k3 = secular_rates(secular_add(s, k2, dt * 0.5), eta, total_mass);
+    SecularRates k4 = secular_rates(secular_add(s, k3, dt), eta, total_mass);
+
+    SecularRates sum;
+    sum.da = k1.da + 2.0 * k2.da + 2.0 * k3.da + k4.da;
+    sum.de = k1.de + 2.0 * k2.de + 2.0 * k3.de + k4.de;
+    sum.dphase = k1.dphase + 2.0 * k2.dphase + 2.0 * k3.dphase + k4.dphase;
+
+    SecularState out = secular_add(s, sum, dt / 6.0);
+    out.time = s.time + dt;
+    if (out.e < 0.0) out.e = 0.0;  // Circularized within one step
+    return out;
+}
+
+SecularState secular_interpolate(
+    const SecularState& s0, const SecularRates& r0,
+    const SecularState& s1, const SecularRates& r1,
+    double t)
+{
+    double h = s1.time - s0.time;
+    if (h <= 0.0) return s0;
+
+    double th = (t - s0.time) / h;
+    double h00 = (1.0 + 2.0 * th) * (1.0 - th) * (1.0 - th);
+    double h10 = th * (1.0 - th) * (1.0 - th);
+    double h01 = th * th * (3.0 - 2.0 * th);
+    double h11 = th * th * (th - 1.0);
+
+    SecularState out = s0;
+    out.a = h00 * s0.a + h10 * h * r0.da + h01 * s1.a + h11 * h * r1.da;
+    out.e = h00 * s0.e + h10 * h * r0.de + h01 * s1.e + h11 * h * r1.de;
+    out.phase = h00 * s0.phase + h10 * h * r0.dphase + h01 * s1.phase + h11 * h * r1.dphase;
+    out.time = t;
+    if (out.e < 0.0) out.e = 0.0;
+    return out;
+}
+
+// ============================================================================
+// Keplerian orbit <-> relative state
+// ============================================================================
+
+SecularState secular_from_relative(const RelativeState& rel, double total_mass)
+{
+    double M = total_mass;
+    double r = glm::length(rel.r);
+    double v2 = glm::dot(rel.v, rel.v);
+
+    SecularState s;
+    s.time = rel.time;
+
+    // Vis-viva: v^2/2 - M/r = -M/(2a)
+    s.a = 1.0 / (2.0 / r - v2 / M);
+
+    // Eccentricity vector points at periapsis
+    glm::dvec3 e_vec = ((v2 - M / r) * rel.r - glm::dot(rel.r, rel.v) * rel.v) / M;
+    s.e = glm::length(e_vec);
+
+    double theta = std::atan2(rel.r.z, rel.r.x);
+    if (s.e < 1e-12) {
+        // Circular: measure the phase from the current position
+        s.e = 0.0;
+        s.periapsis = theta;
+        s.phase = 0.0;
+        return s;
+    }
+
+    s.periapsis = std::atan2(e_vec.z, e_vec.x);
+    double f = theta - s.periapsis;  // True anomaly
+    double E = 2.0 * std::atan2(std::sqrt(1.0 - s.e) * std::sin(0.5 * f),
+                                std::sqrt(1.0 + s.e) * std::cos(0.5 * f));
+    s.phase = E - s.e * std::sin(E);
+    return s;
+}
+
+RelativeState relative_from_secular(const SecularState& s, double total_mass)
+{
+    double M = total_mass;
+    double e = s.e;
+
+    // Solve Kepler's equation E - e sin E = mean anomaly (Newton)
+    double mean_anomaly = std::remainder(s.phase, 2.0 * M_PI);
+    double E = (e < 0.8) ? mean_anomaly : M_PI;
+    for (int i = 0; i < 50; i++) {
+        double dE = (E - e * std::sin(E) - mean_anomaly) / (1.0 - e * std::cos(E));
+        E -= dE;
+        if (std::abs(dE) < 1e-15) break;
+    }
+
+    double f = 2.0 * std::atan2(std::sqrt(1.0 + e) * std::sin(0.5 * E),
+                                std::sqrt(1.0 - e) * std::cos(0.5 * E));
+    double r = s.a * (1.0 - e * std::cos(E));
+    double p = s.a * (1.0 - e * e);
+    double vp = std::sqrt(M / p);
+
+    double theta = s.periapsis + f;
+    glm::dvec3 r_hat(std::cos(theta), 0.0, std::sin(theta));
+    glm::dvec3 t_hat(-std::sin(theta), 0.0, std::cos(theta));
+
+    RelativeState rel;
+    rel.r = r * r_hat;
+    rel.v = vp * e * std::sin(f) * r_hat + vp * (1.0 + e * std::cos(f)) * t_hat;
+    rel.time = s.time;
+    return rel;
+}
+
+bool secular_should_handoff(const SecularState& s, const SecularConfig& config,
+                            double total_mass)
+{
+    if (s.a <= config.handoff_separation) return true;
+    return config.handoff_velocity > 0.0 &&
+           std::sqrt(total_mass / s.a) >= config.handoff_velocity;
+}
+
+} // namespace bh